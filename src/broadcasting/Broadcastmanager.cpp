@@ -44,23 +44,26 @@ void BroadcastManager::broadcastStatus() {
     
     Serial.println("[STATUS] Broadcasting status update");
     
+    char ip[16];
+    char timestamp[TIMESTAMP_LEN];
+    char topic[MQTT_TOPIC_LEN];
+    IPAddress local = WiFi.localIP();
+    snprintf(ip, sizeof(ip), "%u.%u.%u.%u", local[0], local[1], local[2], local[3]);
+    TimeManager::formatTimestamp(timestamp, sizeof(timestamp));
+    snprintf(topic, sizeof(topic), "campus/probes/%s/status", activeConfig->probe_id);
+
     StaticJsonDocument<512> doc;
     doc["probe_id"] = activeConfig->probe_id;
     doc["type"] = "status_broadcast";
     doc["uptime"] = millis() / 1000;
     doc["free_heap"] = ESP.getFreeHeap();
     doc["rssi"] = WiFi.RSSI();
-    doc["ip"] = WiFi.localIP().toString();
+    doc["ip"] = ip;
     doc["ssid"] = WiFi.SSID();
     doc["temp_c"] = temperatureRead();
-    doc["timestamp"] = TimeManager::getTimestamp();
+    doc["timestamp"] = timestamp;
     
-    String payload;
-    serializeJson(doc, payload);
-    
-    String topic = "campus/probes/" + String(activeConfig->probe_id) + "/status";
-    
-    if (MqttManager::publishBroadcast(topic, payload)) {
+    if (MqttManager::publishBroadcast(topic, doc)) {
         Serial.println("[STATUS] ✓ Broadcast published");
     } else {
         Serial.println("[STATUS] ✗ Broadcast failed");
@@ -1,8 +1,11 @@
 #include "CommandHandler.h"
 #include "MqttManager.h"
 #include "../diagnostics/DiagnosticEngine.h"
+#include "../diagnostics/MeasurementTask.h"
 #include "../packaging/JsonPackager.h"
+#include "../packaging/DeltaEncoder.h"
 #include "../storage/ConfigManager.h"
+#include "../connection/ConnectionManager.h"
 
 extern SystemConfig activeCfg; 
 
@@ -28,6 +31,9 @@ if (cmd.type.startsWith("fleet_")) {
     else if (cmd.type == "deep_scan") {
         handleDeepScan(cmd);
     } 
+    else if (cmd.type == "path_probe") {
+        handlePathProbe(cmd);
+    }
     else if (cmd.type == "config_update") {
         handleConfigUpdate(cmd);
     }
@@ -55,6 +61,9 @@ if (cmd.type.startsWith("fleet_")) {
     else if (cmd.type == "ping") {
         handlePing(cmd);
     }
+    else if (cmd.type == "resync") {
+        handleResync(cmd);
+    }
     else if (cmd.type == "get_status") {
         handleGetStatus(cmd);
     }
@@ -71,8 +80,20 @@ void CommandHandler::handleDeepScan(PendingCommand cmd) {
     deserializeJson(doc, cmd.payload);
     int duration = doc["duration"] | 5;
 
+    if (!MeasurementTask::acquireRadio(RADIO_COMMAND_WAIT_MS, MqttManager::keepAlive)) {
+        MqttManager::publishCommandResult("deep_scan", "failed", "{\"error\": \"Radio busy with measurement cycle\"}", cmd.id);
+        return;
+    }
+
+    String targets = doc.containsKey("target") ? doc["target"].as<String>()
+                                               : ConfigManager::getProbeTargets();
+
     Serial.println("[CMD] Starting deep analysis...");
-    EnhancedMetrics em = DiagnosticEngine::performDeepAnalysis("www.google.com");
+    bool sweep = doc["sweep"] | false;
+    bool path = doc["path"] | false;
+    EnhancedMetrics em = DiagnosticEngine::performDeepAnalysis(targets.c_str(), sweep, path);
+    MeasurementTask::releaseRadio();
+    ConnectionManager::reconnect();
     String probeId = String(ConfigManager::load().probe_id);
     
     String resultPayload = JsonPackager::serializeEnhanced(em, probeId); 
@@ -81,6 +102,30 @@ void CommandHandler::handleDeepScan(PendingCommand cmd) {
     Serial.println("[CMD] DEEP SCAN HANDLER COMPLETED");
 }
 
+void CommandHandler::handlePathProbe(PendingCommand cmd) {
+    MqttManager::publishCommandResult("path_probe", "processing", "{\"msg\": \"Path probe initiated\"}", cmd.id);
+
+    DynamicJsonDocument doc(512);
+    deserializeJson(doc, cmd.payload);
+    String target = doc["target"] | "";
+    int maxHops = constrain(doc["max_hops"] | activeCfg.pathMaxHops, 2, PATH_MAX_HOPS);
+
+    if (!MeasurementTask::acquireRadio(RADIO_COMMAND_WAIT_MS, MqttManager::keepAlive)) {
+        MqttManager::publishCommandResult("path_probe", "failed", "{\"error\": \"Radio busy with measurement cycle\"}", cmd.id);
+        return;
+    }
+    PathResult path;
+    bool ok = DiagnosticEngine::tracePath(target.c_str(), maxHops, path);
+    MeasurementTask::releaseRadio();
+
+    if (!ok) {
+        MqttManager::publishCommandResult("path_probe", "failed", "{\"error\": \"No hop answered\"}", cmd.id);
+        return;
+    }
+    String resultPayload = JsonPackager::serializePath(path, String(activeCfg.probe_id));
+    MqttManager::publishCommandResult("path_probe", "completed", resultPayload, cmd.id);
+}
+
 void CommandHandler::handleConfigUpdate(PendingCommand cmd) {
     if (ConfigManager::updateFromJSON(cmd.payload)) {
         MqttManager::publishCommandResult("config_update", "completed", "{\"msg\": \"Config updated. Rebooting.\"}", cmd.id);
@@ -262,6 +307,13 @@ void CommandHandler::handleFactoryReset(PendingCommand cmd) {
     ESP.restart();
 }
 
+// Backend lost the delta chain: next frame is a keyframe, and it comes now
+void CommandHandler::handleResync(PendingCommand cmd) {
+    DeltaEncoder::requestKeyframe();
+    MeasurementTask::requestCycle();
+    MqttManager::publishCommandResult("resync", "completed", "{\"msg\": \"Keyframe scheduled\"}", cmd.id);
+}
+
 void CommandHandler::handlePing(PendingCommand cmd) {
     StaticJsonDocument<512> doc;
     doc["type"] = "pong";
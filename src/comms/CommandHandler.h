@@ -18,11 +18,13 @@ public:
 
 private:
     static void handleDeepScan(PendingCommand cmd);
+    static void handlePathProbe(PendingCommand cmd);
     static void handleConfigUpdate(PendingCommand cmd);
     static void handleRestart(PendingCommand cmd);
     static void handleOTAUpdate(PendingCommand cmd);
     static void handleFactoryReset(PendingCommand cmd);
     static void handlePing(PendingCommand cmd);
+    static void handleResync(PendingCommand cmd);
     static void handleGetStatus(PendingCommand cmd);
     static void handleGetConfig(PendingCommand cmd);
     static void handleSetWifi(PendingCommand cmd);
@@ -1,13 +1,26 @@
 #include "MqttManager.h"
 #include "../fleet/FleetManager.h"
+#include "../packaging/TelemetryBatch.h"
+#include "../packaging/TimeManager.h"
+#include "PublishStream.h"
 
 WiFiClient MqttManager::espClient;
 PubSubClient MqttManager::client(espClient);
 String MqttManager::_probeId;
 PendingCommand MqttManager::_currentCommand;
+PendingCommand MqttManager::_fleetQueue[FLEET_QUEUE_LEN];
+int MqttManager::_fleetHead = 0;
+int MqttManager::_fleetCount = 0;
+PendingCommand MqttManager::_fleetDropped;
+char MqttManager::resultTopic[MQTT_TOPIC_LEN];
+char MqttManager::eventTopic[MQTT_TOPIC_LEN];
+SemaphoreHandle_t MqttManager::clientMutex = NULL;
 
 void MqttManager::setup(const char* broker, int port, String probeId) {
     _probeId = probeId;
+    snprintf(resultTopic, sizeof(resultTopic), "campus/probes/%s/result", probeId.c_str());
+    snprintf(eventTopic, sizeof(eventTopic), "campus/probes/%s/event", probeId.c_str());
+    if (clientMutex == NULL) clientMutex = xSemaphoreCreateMutex();
     client.setServer(broker, port);
     client.setCallback(callback);
     client.setBufferSize(4096);
@@ -38,29 +51,31 @@ void MqttManager::callback(char* topic, byte* payload, unsigned int length) {
         Serial.printf("[MQTT] ║ Command Type: %s\n", commandType.c_str());
         Serial.printf("[MQTT] ║ Command ID: %s\n", commandId.c_str());
         
-        String topicStr = String(topic);
+        PendingCommand cmd;
+        cmd.type = commandType;
+        cmd.id = commandId;
         
-        if (topicStr.indexOf("/fleet/") >= 0 || topicStr.indexOf("/groups/") >= 0) {
-            JsonVariant payloadVar = doc["payload"];
-            DynamicJsonDocument payloadDoc(1024);
-            if (!payloadVar.isNull()) {
-                payloadDoc.set(payloadVar);
-            }
-            
-            FleetManager::processFleetCommand(commandType, payloadDoc, commandId);
+        if (doc.containsKey("payload")) {
+            String payloadStr;
+            serializeJson(doc["payload"], payloadStr);
+            cmd.payload = payloadStr;
         } else {
-            _currentCommand.type = commandType;
-            _currentCommand.id = commandId;
-            
-            if (doc.containsKey("payload")) {
-                String payloadStr;
-                serializeJson(doc["payload"], payloadStr);
-                _currentCommand.payload = payloadStr;
-            } else {
-                _currentCommand.payload = "{}";
-            }
-            
-            _currentCommand.active = true;
+            cmd.payload = "{}";
+        }
+        
+        cmd.active = true;
+
+        // Fleet commands can scan for tens of seconds; run from the main loop
+        // like the rest, so client.loop() never holds the client that long.
+        // Several can land during one offline replay, hence the queue.
+        if (!isFleetTopic(String(topic))) {
+            _currentCommand = cmd;
+        } else if (_fleetCount < FLEET_QUEUE_LEN) {
+            _fleetQueue[(_fleetHead + _fleetCount) % FLEET_QUEUE_LEN] = cmd;
+            _fleetCount++;
+        } else {
+            Serial.println("[MQTT] ║ Fleet command queue full, rejecting");
+            _fleetDropped = cmd;
         }
     } else {
         Serial.println("[MQTT] ║ No 'command' field in JSON!");
@@ -73,20 +88,23 @@ bool MqttManager::reconnect() {
         return false;
     }
     
-    if (!client.connected()) {
+    if (!isConnected()) {
         Serial.print("[MQTT] Attempting connection...");
         String clientId = "ESP32-" + _probeId;
         
-        if (client.connect(clientId.c_str())) {
+        lock();
+        bool connected = client.connect(clientId.c_str());
+        unlock();
+        if (connected) {
             Serial.println(" CONNECTED");
             Serial.printf("[MQTT] Client ID: %s\n", clientId.c_str());
             
             String cmdTopic = "campus/probes/" + _probeId + "/command";
-            if (client.subscribe(cmdTopic.c_str())) {
+            if (subscribe(cmdTopic.c_str())) {
                 Serial.println("[MQTT] SUBSCRIBED TO: " + cmdTopic);
             }
             
-            client.subscribe("campus/fleet/broadcast/command");
+            subscribe("campus/fleet/broadcast/command");
             Serial.println("[MQTT] SUBSCRIBED TO: campus/fleet/broadcast/command");
             
             if (ConfigManager::isFleetManaged()) {
@@ -100,7 +118,7 @@ bool MqttManager::reconnect() {
             Serial.printf(" FAILED, rc=%d\n", client.state());
         }
     }
-    return client.connected();
+    return isConnected();
 }
 
 void MqttManager::subscribeToFleetTopics() {
@@ -112,7 +130,7 @@ void MqttManager::subscribeToFleetTopics() {
     while (end > 0) {
         String group = groups.substring(start, end);
         String groupTopic = "campus/groups/" + group + "/command";
-        if (client.subscribe(groupTopic.c_str())) {
+        if (subscribe(groupTopic.c_str())) {
             Serial.println("[MQTT] SUBSCRIBED TO GROUP: " + groupTopic);
         }
         start = end + 1;
@@ -121,7 +139,7 @@ void MqttManager::subscribeToFleetTopics() {
     if (start < groups.length()) {
         String group = groups.substring(start);
         String groupTopic = "campus/groups/" + group + "/command";
-        if (client.subscribe(groupTopic.c_str())) {
+        if (subscribe(groupTopic.c_str())) {
             Serial.println("[MQTT] SUBSCRIBED TO GROUP: " + groupTopic);
         }
     }
@@ -133,12 +151,7 @@ bool MqttManager::isFleetTopic(String topic) {
 }
 
 bool MqttManager::publishBroadcast(String topic, String payload) {
-    if (!client.connected()) {
-        Serial.println("[MQTT] Not connected, cannot broadcast");
-        return false;
-    }
-    
-    bool success = client.publish(topic.c_str(), payload.c_str());
+    bool success = publishText(topic.c_str(), payload.c_str());
     
     if (success) {
         Serial.printf("[MQTT] Broadcast published to: %s\n", topic.c_str());
@@ -149,15 +162,30 @@ bool MqttManager::publishBroadcast(String topic, String payload) {
     return success;
 }
 
+bool MqttManager::publishBroadcast(const char* topic, const JsonDocument& doc) {
+    bool success = publishJson(topic, doc);
+
+    if (success) {
+        Serial.printf("[MQTT] Broadcast published to: %s\n", topic);
+    } else {
+        Serial.println("[MQTT] Broadcast publish failed");
+    }
+
+    return success;
+}
+
+// The result body is spliced in raw and streamed, so its size is no longer
+// bounded by the client buffer
 bool MqttManager::publishResultInternal(String cmdType, String status, String resultJson, String cmdId) {
-    String topic = "campus/probes/" + _probeId + "/result";
-    
-    DynamicJsonDocument doc(4096);
-    doc["probe_id"] = _probeId;
-    doc["command"] = cmdType;
-    doc["status"] = status;
-    doc["command_id"] = cmdId;
-    doc["timestamp"] = TimeManager::getTimestamp();
+    char timestamp[TIMESTAMP_LEN];
+    TimeManager::formatTimestamp(timestamp, sizeof(timestamp));
+
+    StaticJsonDocument<512> doc;
+    doc["probe_id"] = _probeId.c_str();
+    doc["command"] = cmdType.c_str();
+    doc["status"] = status.c_str();
+    doc["command_id"] = cmdId.c_str();
+    doc["timestamp"] = timestamp;
     
     if (resultJson.length() > 0) {
         doc["result"] = serialized(resultJson.c_str());
@@ -165,18 +193,10 @@ bool MqttManager::publishResultInternal(String cmdType, String status, String re
         doc["result"] = serialized("{}");
     }
 
-    String output;
-    serializeJson(doc, output);
-    
-    if (output.length() > 4096) {
-        Serial.println("[MQTT] ⚠ Result exceeds buffer size!");
-        return false;
-    }
-    
-    bool success = client.publish(topic.c_str(), output.c_str());
+    bool success = publishJson(resultTopic, doc);
     
     if (success) {
-        Serial.printf("[MQTT] Published to: %s\n", topic.c_str());
+        Serial.printf("[MQTT] Published to: %s\n", resultTopic);
     } else {
         Serial.println("[MQTT] Publish failed");
     }
@@ -187,11 +207,9 @@ bool MqttManager::publishResultInternal(String cmdType, String status, String re
 void MqttManager::publishCommandResult(String cmdType, String status, String resultPayload, String cmdId) {
     Serial.printf("[MQTT] Publishing result: cmd=%s, status=%s, id=%s\n", cmdType.c_str(), status.c_str(), cmdId.c_str());
     
-    if (client.connected()) {
-        if (publishResultInternal(cmdType, status, resultPayload, cmdId)) {
-            Serial.println("[MQTT] Result published immediately");
-            return;
-        }
+    if (publishResultInternal(cmdType, status, resultPayload, cmdId)) {
+        Serial.println("[MQTT] Result published immediately");
+        return;
     }
     
     Serial.println("[MQTT] ⚠ Not connected or publish failed, buffering to disk");
@@ -249,6 +267,28 @@ void MqttManager::clearCommand() {
     _currentCommand.payload = "";
 }
 
+bool MqttManager::hasPendingFleetCommand() {
+    return _fleetCount > 0;
+}
+
+PendingCommand MqttManager::getNextFleetCommand() {
+    return _fleetQueue[_fleetHead];
+}
+
+void MqttManager::clearFleetCommand() {
+    if (_fleetCount == 0) return;
+    _fleetQueue[_fleetHead] = PendingCommand();
+    _fleetHead = (_fleetHead + 1) % FLEET_QUEUE_LEN;
+    _fleetCount--;
+}
+
+bool MqttManager::takeDroppedFleetCommand(PendingCommand& cmd) {
+    if (!_fleetDropped.active) return false;
+    cmd = _fleetDropped;
+    _fleetDropped = PendingCommand();
+    return true;
+}
+
 void MqttManager::syncOfflineLogs() {
     if (StorageManager::getBufferSize() == 0) {
         Serial.println("[MQTT] No offline logs to sync");
@@ -267,6 +307,12 @@ void MqttManager::syncOfflineLogs() {
     int synced = 0;
     int failed = 0;
     int start = 0;
+
+    // Plain light samples replay as columnar batches; anything else (deltas,
+    // keyframes, earlier batches) goes out as-is, in order
+    TelemetryBatch batch;
+    bool batching = batch.begin();
+    DynamicJsonDocument sample(4096);
     
     while (start < buffer.length()) {
         int end = buffer.indexOf('\n', start);
@@ -274,42 +320,146 @@ void MqttManager::syncOfflineLogs() {
         
         String line = buffer.substring(start, end);
         line.trim();
-        
-        if (line.length() > 2) {
-            if (client.publish("campus/probes/telemetry", line.c_str())) {
-                synced++;
-            } else {
-                failed++;
+        start = end + 1;
+        if (line.length() <= 2) continue;
+
+        if (batching && deserializeJson(sample, line) == DeserializationError::Ok &&
+            sample["type"] == "light" && !sample.containsKey("seq")) {
+            if (batch.add(sample.as<JsonObjectConst>())) {
+                if (batch.full()) flushBatch(batch, synced, failed);
+                continue;
             }
-            delay(50);
+            // Did not fit: flush and start over, or send it alone below
+            flushBatch(batch, synced, failed);
+            if (batch.add(sample.as<JsonObjectConst>())) continue;
         }
-        
-        start = end + 1;
+        flushBatch(batch, synced, failed);
+
+        if (publishText(MQTT_TELEMETRY_TOPIC, line.c_str())) {
+            synced++;
+        } else {
+            failed++;
+        }
+        poll();
     }
+    flushBatch(batch, synced, failed);
     
     StorageManager::clearBuffer();
     Serial.printf("[MQTT] Offline sync complete: %d synced, %d failed\n", synced, failed);
 }
 
+void MqttManager::flushBatch(TelemetryBatch& batch, int& synced, int& failed) {
+    int n = batch.count();
+    if (n == 0) return;
+
+    if (publishJson(MQTT_TELEMETRY_TOPIC, batch.doc())) {
+        synced += n;
+    } else {
+        failed += n;
+    }
+    batch.reset();
+    poll();
+}
+
 bool MqttManager::publishTelemetry(String payload) {
-    if (client.connected()) {
-        return client.publish("campus/probes/telemetry", payload.c_str());
+    if (isConnected()) {
+        return publishText(MQTT_TELEMETRY_TOPIC, payload.c_str());
     } else {
         return StorageManager::appendToBuffer(payload);
     }
 }
 
+bool MqttManager::publishTelemetry(const JsonDocument& doc, bool& buffered) {
+    buffered = !isConnected();
+    if (!buffered) {
+        return publishJson(MQTT_TELEMETRY_TOPIC, doc);
+    } else {
+        return StorageManager::appendToBuffer(doc);
+    }
+}
+
+bool MqttManager::publishJson(const char* topic, const JsonDocument& doc) {
+    lock();
+    bool ok = false;
+    if (client.connected() && client.beginPublish(topic, measureJson(doc), false)) {
+        PublishStream out(client);
+        serializeJson(doc, out);
+        out.flush();
+        ok = client.endPublish() && out.ok();
+    }
+    unlock();
+    return ok;
+}
+
+bool MqttManager::publishBytes(const char* topic, const uint8_t* payload, size_t len) {
+    lock();
+    bool ok = false;
+    if (client.connected() && client.beginPublish(topic, len, false)) {
+        bool written = client.write(payload, len) == len;
+        ok = client.endPublish() && written;
+    }
+    unlock();
+    return ok;
+}
+
+bool MqttManager::publishText(const char* topic, const char* payload) {
+    lock();
+    bool ok = client.connected() && client.publish(topic, payload);
+    unlock();
+    return ok;
+}
+
+bool MqttManager::subscribe(const char* topic) {
+    lock();
+    bool ok = client.subscribe(topic);
+    unlock();
+    return ok;
+}
+
+void MqttManager::keepAlive() {
+    poll();
+}
+
+// The callback only queues, so this returns as soon as the socket is drained
+bool MqttManager::poll() {
+    lock();
+    bool alive = client.loop();
+    unlock();
+    return alive;
+}
+
+void MqttManager::lock() {
+    if (clientMutex != NULL) xSemaphoreTake(clientMutex, portMAX_DELAY);
+}
+
+void MqttManager::unlock() {
+    if (clientMutex != NULL) xSemaphoreGive(clientMutex);
+}
+
+// Binary telemetry has no offline buffer; the caller falls back to JSON
+bool MqttManager::publishTelemetryPacked(const uint8_t* payload, size_t len) {
+    return publishBytes(MQTT_PACKED_TOPIC, payload, len);
+}
+
 bool MqttManager::loop() {
-    if (!client.connected()) {
+    if (!isConnected()) {
         static unsigned long lastReconnect = 0;
         if (millis() - lastReconnect > 5000) {
             lastReconnect = millis();
             reconnect();
         }
     }
-    return client.loop();
+    return poll();
 }
 
+// connected() may close the socket, so it is checked under the lock too
 bool MqttManager::isConnected(){
-    return client.connected();
-}
\ No newline at end of file
+    lock();
+    bool connected = client.connected();
+    unlock();
+    return connected;
+}
+// Events are only useful while fresh, so they are not buffered offline
+bool MqttManager::publishEvent(String payload) {
+    return publishText(eventTopic, payload.c_str());
+}
@@ -4,9 +4,18 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include "../storage/StorageManager.h"
 #include "../diagnostics/ResultBuffer.h"
 
+#define MQTT_TELEMETRY_TOPIC "campus/probes/telemetry"
+#define MQTT_PACKED_TOPIC "campus/probes/telemetry/msgpack"
+#define MQTT_TOPIC_LEN 96
+#define FLEET_QUEUE_LEN 4
+
+class TelemetryBatch;
+
 struct PendingCommand {
     String type;
     String payload;
@@ -18,14 +27,31 @@ class MqttManager {
 public:
     static void setup(const char* broker, int port, String probeId);
     static bool loop();
+    // Keeps the session alive from inside a long command; anything received is queued
+    static void keepAlive();
     static bool publishTelemetry(String payload);
+    // buffered: the link was down and the document went to the offline log
+    static bool publishTelemetry(const JsonDocument& doc, bool& buffered);
+    static bool publishTelemetryPacked(const uint8_t* payload, size_t len);
+    static bool publishEvent(String payload);
     
     static void publishCommandResult(String cmdType, String status, String resultPayload, String cmdId);  
     static bool publishBroadcast(String topic, String payload);
+    static bool publishBroadcast(const char* topic, const JsonDocument& doc);
+
+    // Streams straight into the socket: measureJson for the length, no String, no client buffer
+    static bool publishJson(const char* topic, const JsonDocument& doc);
+    static bool publishBytes(const char* topic, const uint8_t* payload, size_t len);
 
     static bool hasPendingCommand();
     static PendingCommand getNextCommand();
     static void clearCommand();
+    // Fleet and group commands, queued in arrival order and run from the main loop
+    static bool hasPendingFleetCommand();
+    static PendingCommand getNextFleetCommand();
+    static void clearFleetCommand();
+    // The latest fleet command that arrived with the queue full, to be answered
+    static bool takeDroppedFleetCommand(PendingCommand& cmd);
     static void syncOfflineLogs();
     static void syncBufferedResults();
     
@@ -37,12 +63,27 @@ private:
     static void callback(char* topic, byte* payload, unsigned int length);
     static bool reconnect();
     static bool publishResultInternal(String cmdType, String status, String resultJson, String cmdId);
+    static void flushBatch(TelemetryBatch& batch, int& synced, int& failed);
+    static bool publishText(const char* topic, const char* payload);
+    static bool subscribe(const char* topic);
+    static bool poll();
+    static void lock();
+    static void unlock();
     
     static WiFiClient espClient;
     static PubSubClient client;
     static String _probeId;
+    static char resultTopic[MQTT_TOPIC_LEN];
+    static char eventTopic[MQTT_TOPIC_LEN];
+    // Loop task and broadcast task share the client; held for one read,
+    // subscribe or publish at a time
+    static SemaphoreHandle_t clientMutex;
     
     static PendingCommand _currentCommand;
+    static PendingCommand _fleetQueue[FLEET_QUEUE_LEN];
+    static int _fleetHead;
+    static int _fleetCount;
+    static PendingCommand _fleetDropped;
 };
 
 #endif
\ No newline at end of file
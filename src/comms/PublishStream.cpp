@@ -0,0 +1,29 @@
+#include "PublishStream.h"
+
+PublishStream::PublishStream(PubSubClient& client) : out(client), used(0), good(true) {}
+
+size_t PublishStream::write(uint8_t b) {
+    if (used == sizeof(chunk)) flush();
+    chunk[used++] = b;
+    return 1;
+}
+
+size_t PublishStream::write(const uint8_t* data, size_t len) {
+    size_t left = len;
+    while (left > 0) {
+        if (used == sizeof(chunk)) flush();
+        size_t n = sizeof(chunk) - used;
+        if (n > left) n = left;
+        memcpy(chunk + used, data, n);
+        used += n;
+        data += n;
+        left -= n;
+    }
+    return len;
+}
+
+void PublishStream::flush() {
+    if (used == 0) return;
+    if (out.write(chunk, used) != used) good = false;
+    used = 0;
+}
@@ -0,0 +1,32 @@
+#ifndef PUBLISH_STREAM_H
+#define PUBLISH_STREAM_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+
+#define PUBLISH_CHUNK_SIZE 256
+
+/**
+ * Print adapter between a serializer and an open PubSubClient publish
+ * (beginPublish ... endPublish). ArduinoJson writes a few bytes at a time;
+ * they are gathered in a fixed chunk so the socket sees full segments.
+ * Lives on the stack for one publish; nothing is allocated.
+ */
+class PublishStream : public Print {
+public:
+    explicit PublishStream(PubSubClient& client);
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    void flush() override;
+    // False once any chunk failed to reach the socket
+    bool ok() const { return good; }
+
+private:
+    PubSubClient& out;
+    uint8_t chunk[PUBLISH_CHUNK_SIZE];
+    size_t used;
+    bool good;
+};
+
+#endif
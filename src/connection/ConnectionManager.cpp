@@ -4,6 +4,16 @@ WebServer ConnectionManager::server(80);
 DNSServer ConnectionManager::dnsServer;
 const byte ConnectionManager::DNS_PORT = 53;
 bool ConnectionManager::isPortalActive = false;
+IPAddress ConnectionManager::leaseIp;
+IPAddress ConnectionManager::leaseGateway;
+IPAddress ConnectionManager::leaseMask;
+IPAddress ConnectionManager::leaseDns1;
+IPAddress ConnectionManager::leaseDns2;
+unsigned long ConnectionManager::leaseGrantedAt = 0;
+bool ConnectionManager::usingCachedLease = false;
+int ConnectionManager::lastConnectMs = -1;
+int ConnectionManager::connectCount = 0;
+bool ConnectionManager::lastConnectFast = false;
 
 IPAddress apIP(192, 168, 4, 1);
 IPAddress netMsk(255, 255, 255, 0);
@@ -11,23 +21,124 @@ IPAddress netMsk(255, 255, 255, 0);
 void ConnectionManager::begin() {
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
+    WiFi.onEvent(onGotIp, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    LinkMonitor::begin();
     delay(100);
 }
 
+// Remembers every lease DHCP hands us (a static reuse also raises GOT_IP)
+void ConnectionManager::onGotIp(WiFiEvent_t event, WiFiEventInfo_t info) {
+    if (usingCachedLease) return;
+    leaseIp = WiFi.localIP();
+    leaseGateway = WiFi.gatewayIP();
+    leaseMask = WiFi.subnetMask();
+    leaseDns1 = WiFi.dnsIP(0);
+    leaseDns2 = WiFi.dnsIP(1);
+    leaseGrantedAt = millis();
+}
+
+bool ConnectionManager::waitForLink(uint32_t timeoutMs) {
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
+        delay(10);
+    }
+    return WiFi.status() == WL_CONNECTED;
+}
+
+/**
+ * Targeted association: the cached BSSID and channel skip the all-channel
+ * scan, and a recent lease gets the link up without waiting on DHCP. The
+ * lease then goes straight back to DHCP to be confirmed, before any socket
+ * is opened on it. Bounded by FAST_CONNECT_TIMEOUT_MS plus
+ * DHCP_CONFIRM_TIMEOUT_MS; on failure everything is put back so the full
+ * path starts clean.
+ */
+bool ConnectionManager::tryFastConnect(String ssid, String pass, const LinkHint& hint) {
+    if (!hint.valid || ssid != hint.ssid) return false;
+
+    usingCachedLease = leaseGrantedAt != 0 && millis() - leaseGrantedAt < LEASE_REUSE_MAX_AGE_MS;
+    if (usingCachedLease) {
+        WiFi.config(leaseIp, leaseGateway, leaseMask, leaseDns1, leaseDns2);
+    }
+
+    Serial.printf("[CONN] Fast reconnect to %02X:%02X:%02X:%02X:%02X:%02X ch%d%s\n",
+                  hint.bssid[0], hint.bssid[1], hint.bssid[2], hint.bssid[3], hint.bssid[4], hint.bssid[5],
+                  hint.channel, usingCachedLease ? " (cached lease)" : "");
+    WiFi.begin(ssid.c_str(), pass.c_str(), hint.channel, hint.bssid);
+    if (waitForLink(FAST_CONNECT_TIMEOUT_MS)) {
+        if (usingCachedLease) confirmLease();
+        return true;
+    }
+
+    Serial.println("[CONN] Fast reconnect failed, falling back to full scan");
+    WiFi.disconnect();
+    releaseCachedLease();
+    return false;
+}
+
+// Nothing may hold a socket on the cached address when this runs
+void ConnectionManager::releaseCachedLease() {
+    if (!usingCachedLease) return;
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    usingCachedLease = false;
+}
+
+/**
+ * Hands the interface back to DHCP right after a cached-lease association.
+ * The restarted client asks for its previous address, which the server
+ * normally grants in one round trip; if the server has moved on, we take
+ * whatever it offers rather than keep an address it may already have
+ * given to another host.
+ */
+void ConnectionManager::confirmLease() {
+    IPAddress cached = leaseIp;
+    releaseCachedLease();
+
+    unsigned long start = millis();
+    while ((uint32_t)WiFi.localIP() == 0 && millis() - start < DHCP_CONFIRM_TIMEOUT_MS) {
+        delay(10);
+    }
+    if ((uint32_t)WiFi.localIP() == 0) {
+        Serial.println("[CONN] DHCP has not answered yet, leaving it running");
+    } else if (WiFi.localIP() != cached) {
+        Serial.printf("[CONN] DHCP moved us from %s to %s\n",
+                      cached.toString().c_str(), WiFi.localIP().toString().c_str());
+    }
+}
+
 bool ConnectionManager::tryConnect(String ssid, String pass) {
     if (ssid == "") return false;
 
-    Serial.printf("[CONN] Connecting to %s...", ssid.c_str());
-    WiFi.begin(ssid.c_str(), pass.c_str());
-    int retries = 0;
-    while (WiFi.status() != WL_CONNECTED && retries < 30) {
-        delay(500);
-        Serial.print(".");
-        retries++;
+    unsigned long start = millis();
+    // Normally already back on DHCP; covers a fast path cut short
+    releaseCachedLease();
+    LinkHint hint = StorageManager::loadLinkHint();
+    bool fast = tryFastConnect(ssid, pass, hint);
+
+    if (!fast) {
+        Serial.printf("[CONN] Connecting to %s...", ssid.c_str());
+        WiFi.begin(ssid.c_str(), pass.c_str());
+        int retries = 0;
+        while (WiFi.status() != WL_CONNECTED && retries < 30) {
+            delay(500);
+            Serial.print(".");
+            retries++;
+        }
     }
 
     if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\n[CONN] Connected! IP: " + WiFi.localIP().toString());
+        // The cached AP did not answer and the scan found us another one
+        if (!fast && hint.valid && ssid == hint.ssid &&
+            (memcmp(hint.bssid, WiFi.BSSID(), 6) != 0 || hint.channel != WiFi.channel())) {
+            Serial.println("[CONN] Cached AP is gone, dropping its link hint");
+            StorageManager::clearLinkHint();
+        }
+        lastConnectMs = millis() - start;
+        lastConnectFast = fast;
+        connectCount++;
+        Serial.printf("\n[CONN] Connected in %d ms%s! IP: %s\n", lastConnectMs,
+                      fast ? " (fast path)" : "", WiFi.localIP().toString().c_str());
+        rememberLink(ssid);
         return true;
     } else {
         Serial.println("\n[CONN] Connection Failed.");
@@ -35,6 +146,27 @@ bool ConnectionManager::tryConnect(String ssid, String pass) {
     }
 }
 
+// Only writes NVS when the AP or channel actually changed
+void ConnectionManager::rememberLink(String ssid) {
+    LinkHint current;
+    memset(&current, 0, sizeof(current));
+    current.valid = true;
+    strncpy(current.ssid, ssid.c_str(), sizeof(current.ssid) - 1);
+    memcpy(current.bssid, WiFi.BSSID(), 6);
+    current.channel = WiFi.channel();
+
+    LinkHint stored = StorageManager::loadLinkHint();
+    if (memcmp(&stored, &current, sizeof(current)) != 0) {
+        StorageManager::saveLinkHint(current);
+    }
+}
+
+bool ConnectionManager::reconnect() {
+    if (isConnected()) return true;
+    WifiCredentials creds = StorageManager::loadWifiCredentials();
+    return tryConnect(creds.ssid, creds.password);
+}
+
 void ConnectionManager::startCaptivePortal() {
     isPortalActive = true;
     WiFi.mode(WIFI_AP);
@@ -7,8 +7,12 @@
 #include <ESPmDNS.h>
 #include "../storage/StorageManager.h"
 #include "../storage/ConfigManager.h"
+#include "LinkMonitor.h"
 
 #define MAX_FAILURES 3
+#define FAST_CONNECT_TIMEOUT_MS 1500
+#define LEASE_REUSE_MAX_AGE_MS 600000   // only reuse a lease granted in the last 10 min
+#define DHCP_CONFIRM_TIMEOUT_MS 3000    // wait for DHCP to confirm a reused lease
 
 class ConnectionManager {
 public:
@@ -16,6 +20,12 @@ public:
     static bool establishConnection(String ssid, String pass);
     static void handlePortal(); // Call this in loop()
     static bool isConnected();
+    // Reassociate with the stored credentials after the link was dropped on purpose
+    static bool reconnect();
+
+    static int lastReconnectMs() { return lastConnectMs; }
+    static int reconnectCount() { return connectCount; }
+    static bool lastReconnectFast() { return lastConnectFast; }
 
 private:
     static WebServer server;
@@ -24,6 +34,24 @@ private:
     static bool isPortalActive;
 
     static bool tryConnect(String ssid, String pass);
+    static bool tryFastConnect(String ssid, String pass, const LinkHint& hint);
+    static void releaseCachedLease();
+    static void confirmLease();
+    static bool waitForLink(uint32_t timeoutMs);
+    static void rememberLink(String ssid);
+    static void onGotIp(WiFiEvent_t event, WiFiEventInfo_t info);
+
+    // Last DHCP lease, kept in RAM only: reusing one across reboots risks
+    // an address conflict once the server has handed it to someone else.
+    // A reused lease is static only until the link is up; DHCP then takes
+    // the interface back and renews it as usual.
+    static IPAddress leaseIp, leaseGateway, leaseMask, leaseDns1, leaseDns2;
+    static unsigned long leaseGrantedAt;
+    static bool usingCachedLease;
+
+    static int lastConnectMs;
+    static int connectCount;
+    static bool lastConnectFast;
     static void startCaptivePortal();
     static void handleRoot();
     static void handleSave();
@@ -0,0 +1,203 @@
+#include "LinkMonitor.h"
+
+portMUX_TYPE LinkMonitor::mux = portMUX_INITIALIZER_UNLOCKED;
+LinkEvent LinkMonitor::events[LINK_EVENT_RING_SIZE];
+int LinkMonitor::eventHead = 0;
+int LinkMonitor::eventCount = 0;
+volatile bool LinkMonitor::linkUp = false;
+volatile bool LinkMonitor::disconnectExpected = false;
+LinkRecord LinkMonitor::records[LINK_RECORD_RING_SIZE];
+int LinkMonitor::recordHead = 0;
+int LinkMonitor::recordCount = 0;
+bool LinkMonitor::pending = false;
+bool LinkMonitor::associated = false;
+bool LinkMonitor::quiet = false;
+LinkRecord LinkMonitor::current;
+uint32_t LinkMonitor::connectedAtMs = 0;
+bool LinkMonitor::haveBssid = false;
+uint8_t LinkMonitor::lastBssid[6] = {0};
+int8_t LinkMonitor::lastRssi = 0;
+unsigned long LinkMonitor::lastRssiAt = 0;
+int LinkMonitor::roams = 0;
+
+void LinkMonitor::begin() {
+    linkUp = WiFi.isConnected();
+    WiFi.onEvent(onWifiEvent);
+}
+
+void LinkMonitor::expectDisconnect() {
+    disconnectExpected = true;
+}
+
+// Runs in the Wi-Fi event task: timestamp, copy, and nothing else
+void LinkMonitor::onWifiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    LinkEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.timeMs = millis();
+
+    switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        linkUp = false;
+        ev.type = LINK_DISCONNECTED;
+        ev.reason = info.wifi_sta_disconnected.reason;
+        ev.intentional = disconnectExpected;
+        disconnectExpected = false;
+        memcpy(ev.bssid, info.wifi_sta_disconnected.bssid, 6);
+        break;
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+        ev.type = LINK_CONNECTED;
+        ev.channel = info.wifi_sta_connected.channel;
+        memcpy(ev.bssid, info.wifi_sta_connected.bssid, 6);
+        break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        linkUp = true;
+        ev.type = LINK_GOT_IP;
+        break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+        linkUp = false;
+        ev.type = LINK_LOST_IP;
+        break;
+    default:
+        return;
+    }
+    pushEvent(ev);
+}
+
+void LinkMonitor::pushEvent(const LinkEvent& ev) {
+    portENTER_CRITICAL(&mux);
+    int slot = (eventHead + eventCount) % LINK_EVENT_RING_SIZE;
+    events[slot] = ev;
+    if (eventCount < LINK_EVENT_RING_SIZE) {
+        eventCount++;
+    } else {
+        eventHead = (eventHead + 1) % LINK_EVENT_RING_SIZE;
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+bool LinkMonitor::popEvent(LinkEvent& ev) {
+    bool found = false;
+    portENTER_CRITICAL(&mux);
+    if (eventCount > 0) {
+        ev = events[eventHead];
+        eventHead = (eventHead + 1) % LINK_EVENT_RING_SIZE;
+        eventCount--;
+        found = true;
+    }
+    portEXIT_CRITICAL(&mux);
+    return found;
+}
+
+void LinkMonitor::poll() {
+    LinkEvent ev;
+    while (popEvent(ev)) handle(ev);
+
+    // The disconnect event carries no RSSI, so keep the last good reading
+    if (linkUp && millis() - lastRssiAt >= LINK_RSSI_SAMPLE_MS) {
+        lastRssi = WiFi.RSSI();
+        lastRssiAt = millis();
+        if (!haveBssid && WiFi.BSSID()) {
+            memcpy(lastBssid, WiFi.BSSID(), 6);
+            haveBssid = true;
+        }
+    }
+}
+
+/**
+ * disconnect -> connected -> got IP. An association to a new BSSID without
+ * a preceding disconnect still counts as a roam, with a zero assoc time.
+ * Disconnects before the first association (boot) open no episode, and
+ * neither does an intentional one: everything up to the next IP is ours.
+ */
+void LinkMonitor::handle(const LinkEvent& ev) {
+    switch (ev.type) {
+    case LINK_DISCONNECTED:
+        if (ev.intentional) {
+            quiet = true;
+            pending = false;
+            break;
+        }
+        if (quiet || pending || !haveBssid) break;
+        memset(&current, 0, sizeof(current));
+        pending = true;
+        associated = false;
+        current.atMs = ev.timeMs;
+        current.reason = ev.reason;
+        memcpy(current.oldBssid, lastBssid, 6);
+        current.rssiBefore = lastRssi;
+        break;
+
+    case LINK_CONNECTED:
+        if (!quiet && !pending && haveBssid && memcmp(ev.bssid, lastBssid, 6) != 0) {
+            memset(&current, 0, sizeof(current));
+            pending = true;
+            current.atMs = ev.timeMs;
+            memcpy(current.oldBssid, lastBssid, 6);
+            current.rssiBefore = lastRssi;
+        }
+        memcpy(lastBssid, ev.bssid, 6);
+        haveBssid = true;
+        if (pending) {
+            associated = true;
+            connectedAtMs = ev.timeMs;
+            memcpy(current.newBssid, ev.bssid, 6);
+            current.channel = ev.channel;
+        }
+        break;
+
+    case LINK_GOT_IP:
+        if (quiet) {
+            quiet = false;
+            lastRssi = WiFi.RSSI();
+            lastRssiAt = millis();
+            break;
+        }
+        if (!pending || !associated) break;
+        current.assocMs = connectedAtMs - current.atMs;
+        current.dhcpMs = ev.timeMs - connectedAtMs;
+        current.totalMs = ev.timeMs - current.atMs;
+        current.roamed = memcmp(current.oldBssid, current.newBssid, 6) != 0;
+        current.rssiAfter = WiFi.RSSI();
+        lastRssi = current.rssiAfter;
+        lastRssiAt = millis();
+        if (current.roamed) roams++;
+        pushRecord(current);
+        pending = false;
+
+        Serial.printf("[LINK] %s in %d ms (assoc %d, dhcp %d), reason %d\n",
+                      current.roamed ? "Roamed" : "Reassociated", current.totalMs,
+                      current.assocMs, current.dhcpMs, current.reason);
+        break;
+
+    case LINK_LOST_IP:
+        Serial.println("[LINK] IP lost");
+        break;
+    }
+}
+
+void LinkMonitor::pushRecord(const LinkRecord& r) {
+    int slot = (recordHead + recordCount) % LINK_RECORD_RING_SIZE;
+    records[slot] = r;
+    if (recordCount < LINK_RECORD_RING_SIZE) {
+        recordCount++;
+    } else {
+        recordHead = (recordHead + 1) % LINK_RECORD_RING_SIZE;
+    }
+}
+
+bool LinkMonitor::peekRecord(LinkRecord& out) {
+    if (recordCount == 0) return false;
+    out = records[recordHead];
+    return true;
+}
+
+void LinkMonitor::popRecord() {
+    if (recordCount == 0) return;
+    recordHead = (recordHead + 1) % LINK_RECORD_RING_SIZE;
+    recordCount--;
+}
+
+bool LinkMonitor::linkDown() {
+    // The event may land a moment after WiFi.status() already reports the link
+    return !linkUp && WiFi.status() != WL_CONNECTED;
+}
@@ -0,0 +1,98 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <WiFi.h>
+
+#define LINK_EVENT_RING_SIZE 16
+#define LINK_RECORD_RING_SIZE 8
+#define LINK_RSSI_SAMPLE_MS 1000
+
+enum LinkEventType {
+    LINK_DISCONNECTED,
+    LINK_CONNECTED,
+    LINK_GOT_IP,
+    LINK_LOST_IP
+};
+
+// Raw driver event, timestamped in the Wi-Fi event task
+struct LinkEvent {
+    uint32_t timeMs;
+    uint8_t type;          // LinkEventType
+    uint8_t reason;        // wifi_err_reason_t, disconnects only
+    uint8_t channel;       // connects only
+    bool intentional;      // disconnects we asked for, see expectDisconnect()
+    uint8_t bssid[6];
+};
+
+// One completed loss-to-IP episode, ready to publish
+struct LinkRecord {
+    uint32_t atMs;         // when the link went down
+    bool roamed;           // came back on a different BSSID
+    uint8_t reason;        // first disconnect reason, 0 if none was reported
+    uint8_t oldBssid[6];
+    uint8_t newBssid[6];
+    uint8_t channel;
+    int8_t rssiBefore;     // last reading on the old AP
+    int8_t rssiAfter;      // first reading on the new one
+    int assocMs;           // disassociation to association
+    int dhcpMs;            // association to IP
+    int totalMs;
+};
+
+/**
+ * Link state from the Wi-Fi event callbacks instead of polling. Events are
+ * timestamped as they arrive and parked in a small ring; poll() runs in
+ * loop(), folds them into disconnect -> connected -> got-IP episodes and
+ * queues one LinkRecord per episode. When the ring overflows the oldest
+ * entry is overwritten.
+ */
+class LinkMonitor {
+public:
+    static void begin();
+    static void poll();
+
+    // Call right before dropping the link on purpose (off-channel capture):
+    // the next disconnect and the reconnect after it are not an episode
+    static void expectDisconnect();
+
+    // Set by the disconnect event; only then is WiFi.status() consulted
+    static bool linkDown();
+    static int roamCount() { return roams; }
+
+    // Records stay queued until popped, so a publish can be retried
+    static bool peekRecord(LinkRecord& out);
+    static void popRecord();
+
+private:
+    static void onWifiEvent(WiFiEvent_t event, WiFiEventInfo_t info);
+    static void pushEvent(const LinkEvent& ev);
+    static bool popEvent(LinkEvent& ev);
+    static void handle(const LinkEvent& ev);
+    static void pushRecord(const LinkRecord& r);
+
+    static portMUX_TYPE mux;
+    static LinkEvent events[LINK_EVENT_RING_SIZE];
+    static int eventHead;
+    static int eventCount;
+    static volatile bool linkUp;
+    static volatile bool disconnectExpected;
+
+    static LinkRecord records[LINK_RECORD_RING_SIZE];
+    static int recordHead;
+    static int recordCount;
+
+    // Episode being assembled
+    static bool pending;
+    static bool associated;
+    static bool quiet;             // between an intentional disconnect and the next IP
+    static LinkRecord current;
+    static uint32_t connectedAtMs;
+
+    static bool haveBssid;
+    static uint8_t lastBssid[6];
+    static int8_t lastRssi;
+    static unsigned long lastRssiAt;
+    static int roams;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "Airtime.h"
+
+// Data bits per OFDM symbol for HT MCS 0-7, one spatial stream
+static const uint16_t htBitsPerSymbol20[8] = { 26, 52, 78, 104, 156, 208, 234, 260 };
+static const uint16_t htBitsPerSymbol40[8] = { 54, 108, 162, 216, 324, 432, 486, 540 };
+
+// wifi_phy_rate_t values below 0x10 -> rate in 100 kbps, 0 if unused
+static const uint16_t legacyRate100k[16] = {
+    10, 20, 55, 110,    // 0x00-0x03 DSSS/CCK, long preamble
+    0, 20, 55, 110,     // 0x05-0x07 short preamble
+    480, 240, 120, 60,  // 0x08-0x0B OFDM
+    540, 360, 180, 90   // 0x0C-0x0F
+};
+
+static bool isResponseFrame(uint8_t fc) {
+    uint8_t sub = fc & 0xFC;
+    return sub == 0xD4 || sub == 0xC4 || sub == 0x94;  // ACK, CTS, BlockAck
+}
+
+static uint32_t ofdmSymbols(uint32_t bits, uint32_t bitsPerSymbol) {
+    return (bits + bitsPerSymbol - 1) / bitsPerSymbol;
+}
+
+uint32_t frameAirtimeUs(const FrameSummary& f) {
+    // 16 service bits + 6 tail bits around the PSDU for every OFDM format
+    uint32_t psduBits = 16 + 8u * f.len + 6;
+    bool ampdu = f.flags & FRAME_FLAG_AMPDU;
+    uint32_t ifs = isResponseFrame(f.fc) ? AIRTIME_SIFS_US : AIRTIME_DIFS_OFDM_US;
+
+    if (f.flags & FRAME_FLAG_HT) {
+        uint8_t mcs = f.rate;
+        uint8_t streams = mcs / 8 + 1;
+        const uint16_t* table = (f.flags & FRAME_FLAG_40MHZ) ? htBitsPerSymbol40 : htBitsPerSymbol20;
+        uint32_t bitsPerSymbol = table[mcs % 8] * streams;
+
+        if (ampdu) psduBits = 8u * (f.len + 4);  // subframe plus delimiter
+        uint32_t symbols = ofdmSymbols(psduBits, bitsPerSymbol);
+        uint32_t dataUs = (f.flags & FRAME_FLAG_SGI) ? (symbols * 36 + 9) / 10 : symbols * 4;
+        if (ampdu) return dataUs;
+
+        return ifs + AIRTIME_HT_PREAMBLE_US + (streams - 1) * AIRTIME_HT_LTF_US +
+               dataUs + AIRTIME_SIGNAL_EXT_US;
+    }
+
+    uint16_t rate = f.rate < 16 ? legacyRate100k[f.rate] : 0;
+    if (rate == 0) rate = 10;  // unknown: assume the slowest rate
+
+    if (f.rate <= 0x07) {
+        uint32_t preamble = f.rate <= 0x03 ? AIRTIME_DSSS_LONG_US : AIRTIME_DSSS_SHORT_US;
+        uint32_t payloadUs = (8u * f.len * 10 + rate - 1) / rate;
+        uint32_t difs = isResponseFrame(f.fc) ? AIRTIME_SIFS_US : AIRTIME_DIFS_DSSS_US;
+        return difs + preamble + payloadUs;
+    }
+
+    // 4 us symbols carry rate(Mbps) x 4 bits
+    uint32_t bitsPerSymbol = rate * 4 / 10;
+    return ifs + AIRTIME_OFDM_PREAMBLE_US + ofdmSymbols(psduBits, bitsPerSymbol) * 4 +
+           AIRTIME_SIGNAL_EXT_US;
+}
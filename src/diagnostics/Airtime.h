@@ -0,0 +1,26 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include "FrameRing.h"
+
+// 2.4 GHz timing (802.11-2016, clauses 15-19)
+#define AIRTIME_SIFS_US          10
+#define AIRTIME_DIFS_OFDM_US     28    // SIFS + 2 x 9 us short slot
+#define AIRTIME_DIFS_DSSS_US     50    // SIFS + 2 x 20 us long slot
+#define AIRTIME_SIGNAL_EXT_US    6     // ERP-OFDM / HT signal extension
+#define AIRTIME_DSSS_LONG_US     192
+#define AIRTIME_DSSS_SHORT_US    96
+#define AIRTIME_OFDM_PREAMBLE_US 20    // L-STF + L-LTF + L-SIG
+#define AIRTIME_HT_PREAMBLE_US   36    // + HT-SIG, HT-STF, first HT-LTF
+#define AIRTIME_HT_LTF_US        4     // each additional spatial stream
+
+/**
+ * Estimated time on air for one captured frame in microseconds: preamble,
+ * PSDU symbols at the received rate or MCS, and the interframe space that
+ * precedes it. SIFS for response frames (ACK, CTS, BlockAck), DIFS for
+ * everything else. A-MPDU subframes count payload only, since the driver
+ * reports each subframe separately and they share one preamble.
+ */
+uint32_t frameAirtimeUs(const FrameSummary& f);
+
+#endif
@@ -0,0 +1,104 @@
+#include "BeaconTracker.h"
+
+BeaconEntry BeaconTracker::table[BEACON_TABLE_SIZE];
+int BeaconTracker::used = 0;
+
+void BeaconTracker::reset() {
+    memset(table, 0, sizeof(table));
+    used = 0;
+}
+
+BeaconEntry* BeaconTracker::find(const uint8_t* bssid, bool insert) {
+    // The low BSSID bytes vary most between APs
+    uint32_t h = (bssid[3] << 16) ^ (bssid[4] << 8) ^ bssid[5];
+    h ^= h >> 7;
+
+    for (int i = 0; i < BEACON_TABLE_SIZE; i++) {
+        BeaconEntry& e = table[(h + i) & (BEACON_TABLE_SIZE - 1)];
+        if (e.used && memcmp(e.bssid, bssid, 6) == 0) return &e;
+        if (!e.used) {
+            if (!insert) return nullptr;
+            memcpy(e.bssid, bssid, 6);
+            e.used = true;
+            used++;
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+void BeaconTracker::record(const FrameSummary& f) {
+    if ((f.fc & 0xFC) != 0x80 || f.beaconIntervalTu == 0) return;
+
+    BeaconEntry* e = find(f.bssid, true);
+    if (!e) return;
+
+    if (e->beacons > 0) {
+        uint32_t gapUs = f.timestampUs - e->lastTimestampUs;
+        uint32_t intervalUs = (uint32_t)f.beaconIntervalTu * BEACON_TU_US;
+        // Round to the nearest number of intervals; one interval is no loss
+        uint32_t periods = (gapUs + intervalUs / 2) / intervalUs;
+        if (periods > 1) e->missed += periods - 1;
+    }
+
+    e->intervalTu = f.beaconIntervalTu;
+    e->lastSeq = f.seq;
+    e->lastTimestampUs = f.timestampUs;
+    e->beacons++;
+    e->rssiSum += f.rssi;
+}
+
+void BeaconTracker::toStats(const BeaconEntry& e, ApBeaconStats& out) {
+    memcpy(out.bssid, e.bssid, 6);
+    out.rssi = e.beacons > 0 ? (int8_t)(e.rssiSum / e.beacons) : 0;
+    out.intervalTu = e.intervalTu;
+    out.beacons = e.beacons;
+    out.missed = e.missed;
+    int expected = e.beacons + e.missed;
+    out.lossPct = expected > 0 ? 100.0f * e.missed / expected : 0;
+}
+
+int BeaconTracker::apCount() {
+    return used;
+}
+
+bool BeaconTracker::lookup(const uint8_t* bssid, ApBeaconStats& out) {
+    BeaconEntry* e = find(bssid, false);
+    if (!e) return false;
+    toStats(*e, out);
+    return true;
+}
+
+int BeaconTracker::neighbors(const uint8_t* ownBssid, ApBeaconStats* out, int max) {
+    int n = 0;
+    for (int i = 0; i < BEACON_TABLE_SIZE; i++) {
+        const BeaconEntry& e = table[i];
+        if (!e.used || (ownBssid && memcmp(e.bssid, ownBssid, 6) == 0)) continue;
+
+        ApBeaconStats s;
+        toStats(e, s);
+
+        // Insertion into a list kept sorted by RSSI, strongest first
+        int pos = n < max ? n : max;
+        while (pos > 0 && out[pos - 1].rssi < s.rssi) {
+            if (pos < max) out[pos] = out[pos - 1];
+            pos--;
+        }
+        if (pos < max) {
+            out[pos] = s;
+            if (n < max) n++;
+        }
+    }
+    return n;
+}
+
+void BeaconTracker::neighborTotals(const uint8_t* ownBssid, int& beacons, int& missed) {
+    beacons = 0;
+    missed = 0;
+    for (int i = 0; i < BEACON_TABLE_SIZE; i++) {
+        const BeaconEntry& e = table[i];
+        if (!e.used || (ownBssid && memcmp(e.bssid, ownBssid, 6) == 0)) continue;
+        beacons += e.beacons;
+        missed += e.missed;
+    }
+}
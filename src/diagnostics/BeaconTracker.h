@@ -0,0 +1,59 @@
+#ifndef BEACON_TRACKER_H
+#define BEACON_TRACKER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "FrameRing.h"
+
+#define BEACON_TABLE_SIZE 32      // power of two
+#define BEACON_MAX_REPORTED 8
+#define BEACON_TU_US 1024
+
+struct BeaconEntry {
+    uint8_t bssid[6];
+    bool used;
+    uint16_t intervalTu;      // advertised beacon interval
+    uint16_t lastSeq;
+    uint32_t lastTimestampUs;
+    int beacons;
+    int missed;
+    int32_t rssiSum;
+};
+
+struct ApBeaconStats {
+    uint8_t bssid[6];
+    int8_t rssi;              // mean over received beacons
+    uint16_t intervalTu;
+    int beacons;
+    int missed;
+    float lossPct;            // missed / (beacons + missed)
+};
+
+/**
+ * Beacon accounting per BSSID in a fixed open-addressed table (linear
+ * probing). Missed beacons come from receive-time gaps measured against the
+ * AP's own advertised interval, since sequence numbers are shared with
+ * probe responses and other management frames. When the table is full,
+ * beacons from further APs are ignored.
+ */
+class BeaconTracker {
+public:
+    static void reset();
+    static void record(const FrameSummary& f);
+
+    static int apCount();
+    static bool lookup(const uint8_t* bssid, ApBeaconStats& out);
+    // Strongest APs other than ownBssid, up to max; returns how many were written
+    static int neighbors(const uint8_t* ownBssid, ApBeaconStats* out, int max);
+    // Totals over every AP other than ownBssid
+    static void neighborTotals(const uint8_t* ownBssid, int& beacons, int& missed);
+
+private:
+    static BeaconEntry* find(const uint8_t* bssid, bool insert);
+    static void toStats(const BeaconEntry& e, ApBeaconStats& out);
+
+    static BeaconEntry table[BEACON_TABLE_SIZE];
+    static int used;
+};
+
+#endif
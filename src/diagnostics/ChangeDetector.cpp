@@ -0,0 +1,69 @@
+#include "ChangeDetector.h"
+#include <math.h>
+
+void ChangeDetector::reset() {
+    mu = 0;
+    var = 0;
+    sHigh = 0;
+    sLow = 0;
+    n = 0;
+}
+
+float ChangeDetector::sigma() const {
+    float s = sqrtf(var);
+    return s > minSigma ? s : minSigma;
+}
+
+bool ChangeDetector::within(float x, float bandSigmas) const {
+    if (n < CHANGE_WARMUP_SAMPLES) return false;
+    return fabsf(x - mu) <= bandSigmas * sigma();
+}
+
+int ChangeDetector::add(float x) {
+    // Warm-up: plain running mean/variance so the EWMA starts from a
+    // sensible baseline instead of the first sample
+    if (n < CHANGE_WARMUP_SAMPLES) {
+        n++;
+        float d = x - mu;
+        mu += d / n;
+        var += (d * (x - mu) - var) / n;
+        return 0;
+    }
+    n++;
+
+    float z = (x - mu) / sigma();
+    z = fmaxf(-CHANGE_Z_CLAMP, fminf(CHANGE_Z_CLAMP, z));
+    sHigh = fmaxf(0, sHigh + z - CHANGE_CUSUM_K);
+    sLow = fmaxf(0, sLow - z - CHANGE_CUSUM_K);
+
+    int shift = 0;
+    if (sHigh > CHANGE_CUSUM_H) shift = 1;
+    else if (sLow > CHANGE_CUSUM_H) shift = -1;
+
+    if (shift != 0) {
+        // Learn the new level from scratch rather than chase it
+        reset();
+        add(x);
+        return shift;
+    }
+
+    // Hold the baseline while evidence of a shift is building, otherwise a
+    // slow drift would be absorbed into it before CUSUM could fire
+    if (sHigh > CHANGE_CUSUM_H / 2 || sLow > CHANGE_CUSUM_H / 2) return 0;
+
+    // Residual winsorized like z, so one wild sample cannot drag the baseline
+    float d = z * sigma();
+    mu += CHANGE_EWMA_ALPHA * d;
+    var = (1 - CHANGE_EWMA_ALPHA) * (var + CHANGE_EWMA_ALPHA * d * d);
+    return 0;
+}
+
+const char* changeMetricName(uint8_t metric) {
+    switch (metric) {
+    case CHANGE_RSSI: return "rssi";
+    case CHANGE_LATENCY: return "lat";
+    case CHANGE_LOSS: return "loss";
+    case CHANGE_DNS: return "dns";
+    default: return "unknown";
+    }
+}
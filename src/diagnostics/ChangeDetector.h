@@ -0,0 +1,64 @@
+#ifndef CHANGE_DETECTOR_H
+#define CHANGE_DETECTOR_H
+
+#include <stdint.h>
+
+#define CHANGE_WARMUP_SAMPLES 16    // baseline only, no alarms
+#define CHANGE_EWMA_ALPHA 0.05f
+#define CHANGE_CUSUM_K 0.5f         // slack, in baseline standard deviations
+#define CHANGE_CUSUM_H 8.0f         // alarm threshold, same units
+#define CHANGE_Z_CLAMP 4.0f         // one sample can add at most this much
+
+enum ChangeMetric {
+    CHANGE_RSSI,
+    CHANGE_LATENCY,
+    CHANGE_LOSS,
+    CHANGE_DNS,
+    CHANGE_METRIC_COUNT
+};
+
+// POD so it can travel through a FreeRTOS queue
+struct ChangeEvent {
+    uint8_t metric;       // ChangeMetric
+    int8_t direction;     // +1 shifted up, -1 shifted down
+    bool degraded;        // the shift is in the bad direction for this metric
+    float value;          // sample that raised the alarm
+    float baseline;       // EWMA mean before the shift
+    float sigma;          // baseline standard deviation used for scoring
+    bool deepScan;        // an automatic deep scan was queued because of it
+};
+
+/**
+ * EWMA baseline with a two-sided CUSUM on the standardized residual.
+ * Small sustained shifts accumulate until they cross CHANGE_CUSUM_H, while
+ * a single outlier only adds one bounded step. After an alarm the baseline
+ * is learned again from the new level so one shift raises one event.
+ */
+class ChangeDetector {
+public:
+    ChangeDetector() : minSigma(1.0f) { reset(); }
+    explicit ChangeDetector(float minSigma) : minSigma(minSigma) { reset(); }
+
+    void reset();
+    // Returns +1 / -1 when a shift up / down is detected, 0 otherwise
+    int add(float x);
+
+    // Baseline learned and x no further than bandSigmas from it
+    bool within(float x, float bandSigmas) const;
+
+    float mean() const { return mu; }
+    float sigma() const;
+    int count() const { return n; }
+
+private:
+    float minSigma;       // floor so a very quiet baseline does not alarm on noise
+    float mu;
+    float var;
+    float sHigh;
+    float sLow;
+    int n;
+};
+
+const char* changeMetricName(uint8_t metric);
+
+#endif
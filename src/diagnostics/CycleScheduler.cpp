@@ -0,0 +1,163 @@
+#include "CycleScheduler.h"
+
+ProbeModule CycleScheduler::modules[SCHED_MAX_MODULES];
+int CycleScheduler::moduleCount = 0;
+float CycleScheduler::costEstimate[SCHED_MAX_MODULES];
+unsigned long CycleScheduler::lastRun[SCHED_MAX_MODULES];
+bool CycleScheduler::hasRun[SCHED_MAX_MODULES];
+
+uint8_t CycleScheduler::order[SCHED_MAX_MODULES];
+int CycleScheduler::orderCount = 0;
+int CycleScheduler::cursor = 0;
+bool CycleScheduler::inProgress = false;
+unsigned long CycleScheduler::planStart = 0;
+unsigned long CycleScheduler::moduleStart = 0;
+unsigned long CycleScheduler::settleUntil = 0;
+uint32_t CycleScheduler::budget = 0;
+uint16_t CycleScheduler::deferred = 0;
+
+int CycleScheduler::add(const ProbeModule& module) {
+    if (moduleCount >= SCHED_MAX_MODULES) return -1;
+    int i = moduleCount++;
+    modules[i] = module;
+    costEstimate[i] = module.costMs;
+    lastRun[i] = 0;
+    hasRun[i] = false;
+    return i;
+}
+
+const char* CycleScheduler::name(int index) {
+    if (index < 0 || index >= moduleCount) return "";
+    return modules[index].name;
+}
+
+bool CycleScheduler::isEnabled(int index, const SystemConfig& cfg) {
+    return modules[index].enabled == NULL || modules[index].enabled(cfg);
+}
+
+bool CycleScheduler::due(int index, unsigned long now) {
+    const ProbeModule& mod = modules[index];
+    if (!hasRun[index] || mod.periodS == 0) return true;
+    return now - lastRun[index] >= mod.periodS * 1000UL;
+}
+
+// Age over desired spacing; every-cycle modules measure against the budget
+float CycleScheduler::urgency(int index, unsigned long now, uint32_t budgetMs) {
+    if (!hasRun[index]) return 1e9f;
+    const ProbeModule& mod = modules[index];
+    float span = mod.periodS > 0 ? mod.periodS * 1000.0f : (float)budgetMs;
+    return (now - lastRun[index]) / span;
+}
+
+void CycleScheduler::plan(const SystemConfig& cfg, uint32_t budgetMs) {
+    unsigned long now = millis();
+    budget = budgetMs;
+    deferred = 0;
+    orderCount = 0;
+    cursor = 0;
+    inProgress = false;
+    planStart = now;
+
+    bool chosen[SCHED_MAX_MODULES];
+    float wallMs = 0;
+    float airMs = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        chosen[i] = modules[i].essential && isEnabled(i, cfg);
+        if (chosen[i]) {
+            wallMs += costEstimate[i];
+            airMs += modules[i].airtimeMs;
+        }
+    }
+
+    // Optional modules that are due, most overdue first
+    int candidates[SCHED_MAX_MODULES];
+    float score[SCHED_MAX_MODULES];
+    int n = 0;
+    for (int i = 0; i < moduleCount; i++) {
+        if (modules[i].essential || !isEnabled(i, cfg) || !due(i, now)) continue;
+        float u = urgency(i, now, budgetMs);
+        int j = n++;
+        while (j > 0 && score[j - 1] < u) {
+            candidates[j] = candidates[j - 1];
+            score[j] = score[j - 1];
+            j--;
+        }
+        candidates[j] = i;
+        score[j] = u;
+    }
+
+    for (int c = 0; c < n; c++) {
+        int i = candidates[c];
+        if (wallMs + costEstimate[i] <= budgetMs &&
+            airMs + modules[i].airtimeMs <= SCHED_AIRTIME_BUDGET_MS) {
+            chosen[i] = true;
+            wallMs += costEstimate[i];
+            airMs += modules[i].airtimeMs;
+        } else {
+            deferred |= (uint16_t)(1 << i);
+        }
+    }
+
+    for (int kind = PROBE_PASSIVE; kind <= PROBE_DISRUPTIVE; kind++) {
+        for (int i = 0; i < moduleCount; i++) {
+            if (chosen[i] && modules[i].kind == kind) order[orderCount++] = i;
+        }
+    }
+
+    Serial.printf("[SCHED] %d modules, ~%d ms of %lu ms budget\n",
+                  orderCount, (int)wallMs, (unsigned long)budgetMs);
+}
+
+/**
+ * Runs the plan one module (or one poll of an asynchronous module) per call.
+ * Estimates can be off, so an optional module is still dropped here when
+ * the time already spent leaves no room for it.
+ */
+SchedStep CycleScheduler::step(NetworkMetrics& m, const SystemConfig& cfg) {
+    if (cursor >= orderCount) return SCHED_DONE;
+
+    int i = order[cursor];
+    const ProbeModule& mod = modules[i];
+    unsigned long now = millis();
+
+    if (!inProgress) {
+        if (mod.kind == PROBE_SENSITIVE && (long)(settleUntil - now) > 0) return SCHED_WAIT;
+
+        if (!mod.essential && now - planStart + costEstimate[i] > budget) {
+            Serial.printf("[SCHED] %s deferred, budget spent\n", mod.name);
+            deferred |= (uint16_t)(1 << i);
+            cursor++;
+            return cursor >= orderCount ? SCHED_DONE : SCHED_BUSY;
+        }
+        inProgress = true;
+        moduleStart = now;
+    }
+
+    if (!mod.run(m, cfg)) return SCHED_WAIT;
+
+    finish(i, millis());
+    Serial.printf("[SCHED] %s: %lu ms\n", mod.name, millis() - moduleStart);
+    inProgress = false;
+    cursor++;
+    return cursor >= orderCount ? SCHED_DONE : SCHED_BUSY;
+}
+
+void CycleScheduler::finish(int index, unsigned long now) {
+    float measured = (float)(now - moduleStart);
+    costEstimate[index] += SCHED_COST_ALPHA * (measured - costEstimate[index]);
+    lastRun[index] = now;
+    hasRun[index] = true;
+    if (modules[index].kind == PROBE_DISRUPTIVE) settleUntil = now + SCHED_SETTLE_MS;
+}
+
+void CycleScheduler::runAll(NetworkMetrics& m, const SystemConfig& cfg) {
+    for (int kind = PROBE_PASSIVE; kind <= PROBE_DISRUPTIVE; kind++) {
+        for (int i = 0; i < moduleCount; i++) {
+            const ProbeModule& mod = modules[i];
+            if (mod.kind != kind || !isEnabled(i, cfg)) continue;
+            while (!mod.run(m, cfg)) {
+                delay(20);
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef CYCLE_SCHEDULER_H
+#define CYCLE_SCHEDULER_H
+
+#include <Arduino.h>
+#include "DiagnosticEngine.h"
+#include "../storage/ConfigManager.h"
+
+#define SCHED_MAX_MODULES 12
+#define SCHED_COST_ALPHA 0.25f          // weight of the newest measured run time
+#define SCHED_SETTLE_MS 250             // radio settle time after a disruptive module
+#define SCHED_AIRTIME_BUDGET_MS 1500    // on-air/off-channel time per cycle, optional modules
+
+enum ProbeKind {
+    PROBE_PASSIVE,      // reads local state, sends nothing
+    PROBE_SENSITIVE,    // timing probes: skewed by anything else using the radio
+    PROBE_DISRUPTIVE    // leaves the channel or floods it (scans)
+};
+
+enum SchedStep {
+    SCHED_BUSY,         // moved on, call again right away
+    SCHED_WAIT,         // an asynchronous module or the settle gap; back off briefly
+    SCHED_DONE
+};
+
+// Returns true when finished; false asks to be called again (asynchronous work)
+typedef bool (*ProbeRunFn)(NetworkMetrics& m, const SystemConfig& cfg);
+typedef bool (*ProbeEnabledFn)(const SystemConfig& cfg);
+
+struct ProbeModule {
+    const char* name;
+    uint8_t kind;               // ProbeKind
+    uint16_t costMs;            // expected wall time; refined from measured runs
+    uint16_t airtimeMs;         // expected time on air or off channel
+    uint32_t periodS;           // desired spacing between runs, 0 for every cycle
+    bool essential;             // scheduled every cycle whatever the budget
+    ProbeEnabledFn enabled;     // NULL: always enabled
+    ProbeRunFn run;
+};
+
+/**
+ * Packs registered probe modules into a per-cycle time budget. Due modules
+ * are taken essential-first and then by how overdue they are, as long as
+ * their learned cost fits the remaining wall time and airtime; the rest are
+ * deferred to a later cycle. Chosen modules run passive first, then the
+ * latency-sensitive ones, and disruptive ones last, so a scan never sits
+ * between two timing probes. Registration order is kept within a kind,
+ * which is how a module can rely on one registered before it.
+ */
+class CycleScheduler {
+public:
+    // Returns the module's index, -1 when the registry is full
+    static int add(const ProbeModule& module);
+    static int count() { return moduleCount; }
+    static const char* name(int index);
+
+    static void plan(const SystemConfig& cfg, uint32_t budgetMs);
+    static SchedStep step(NetworkMetrics& m, const SystemConfig& cfg);
+    // Modules skipped this cycle, bit i for module i
+    static uint16_t deferredMask() { return deferred; }
+
+    // Every enabled module in one go, no budget or period; leaves the schedule alone
+    static void runAll(NetworkMetrics& m, const SystemConfig& cfg);
+
+private:
+    static bool isEnabled(int index, const SystemConfig& cfg);
+    static bool due(int index, unsigned long now);
+    static float urgency(int index, unsigned long now, uint32_t budgetMs);
+    static void finish(int index, unsigned long now);
+
+    static ProbeModule modules[SCHED_MAX_MODULES];
+    static int moduleCount;
+    static float costEstimate[SCHED_MAX_MODULES];
+    static unsigned long lastRun[SCHED_MAX_MODULES];
+    static bool hasRun[SCHED_MAX_MODULES];
+
+    static uint8_t order[SCHED_MAX_MODULES];
+    static int orderCount;
+    static int cursor;
+    static bool inProgress;
+    static unsigned long planStart;
+    static unsigned long moduleStart;
+    static unsigned long settleUntil;
+    static uint32_t budget;
+    static uint16_t deferred;
+};
+
+#endif
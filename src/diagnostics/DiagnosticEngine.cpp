@@ -1,45 +1,253 @@
 #include "DiagnosticEngine.h"
-#include "SnifferEngine.h"
+#include "NeighborScanner.h"
+#include "IcmpEngine.h"
+#include "ThroughputEngine.h"
+#include "CycleScheduler.h"
+#include "../connection/ConnectionManager.h"
 #include <esp_wifi.h>
 
+// Sigma floors: below these a change is not worth an event
+ChangeDetector DiagnosticEngine::detectors[CHANGE_METRIC_COUNT] = {
+    ChangeDetector(2.0f),   // RSSI, dB
+    ChangeDetector(3.0f),   // latency, ms
+    ChangeDetector(2.0f),   // loss, %
+    ChangeDetector(5.0f)    // DNS, ms
+};
+QueueHandle_t DiagnosticEngine::eventQueue = NULL;
+volatile bool DiagnosticEngine::autoScanPending = false;
+volatile uint8_t DiagnosticEngine::autoScanMetric = 0;
+bool DiagnosticEngine::autoScanRan = false;
+unsigned long DiagnosticEngine::lastAutoScan = 0;
+PathResult DiagnosticEngine::cachedPath;
+bool DiagnosticEngine::pathCached = false;
+float DiagnosticEngine::pathBaselineRtt = -1;
+unsigned long DiagnosticEngine::pathTracedAt = 0;
+
 /**
  * Standard Monitoring: Captures metrics while connected to the AP.
  * This is the "Light" telemetry used for 30-second heartbeats.
  */
-NetworkMetrics DiagnosticEngine::performFullTest(const char* targetHost) {
-    NetworkMetrics metrics;
+NetworkMetrics DiagnosticEngine::performFullTest(const char* targetList) {
+    NetworkMetrics metrics = {};
+    SystemConfig cfg = ConfigManager::load();
+    strncpy(cfg.probeTargets, targetList, sizeof(cfg.probeTargets) - 1);
+    cfg.probeTargets[sizeof(cfg.probeTargets) - 1] = '\0';
 
-    // 1. Physical Layer Connection Stats
-    metrics.rssi = WiFi.RSSI();
-    metrics.bssid = WiFi.BSSIDstr();
-    metrics.channel = WiFi.channel();
+    registerModules();
+    CycleScheduler::runAll(metrics, cfg);
 
-    // 2. Neighbor Scan & Congestion Analysis
-    int n = WiFi.scanNetworks(false, false, false, 300); 
-    metrics.neighborCount = n;
-    
-    int overlapping = 0;
-    for (int i = 0; i < n; ++i) {
-        if (WiFi.channel(i) == metrics.channel) {
-            overlapping++;
+    return metrics;
+}
+
+/**
+ * Built-in probe modules. Costs are starting points, the scheduler learns
+ * the real ones; airtime is what the module puts on the air or spends off
+ * channel. Path tracing reads the latency results, so it is registered
+ * after latency (same kind, so it also runs after it).
+ */
+void DiagnosticEngine::registerModules() {
+    if (CycleScheduler::count() > 0) return;
+
+    //                   name       kind              cost  air  period essential enabled      run
+    CycleScheduler::add({"link",    PROBE_PASSIVE,       5,    0,   0, true,  NULL,        runLink});
+    CycleScheduler::add({"noise",   PROBE_PASSIVE,     200,    0,   0, false, NULL,        runNoise});
+    CycleScheduler::add({"latency", PROBE_SENSITIVE,  3000,   50,   0, true,  NULL,        runLatency});
+    CycleScheduler::add({"path",    PROBE_SENSITIVE,   300,   30,   0, false, pathEnabled, runPath});
+    CycleScheduler::add({"dns",     PROBE_SENSITIVE,  1000,   20,   0, true,  NULL,        runDns});
+    CycleScheduler::add({"http",    PROBE_SENSITIVE,  3000,  200,  60, false, httpEnabled, runHttp});
+    CycleScheduler::add({"scan",    PROBE_DISRUPTIVE,  500,  360,   0, false, NULL,        runScan});
+}
+
+bool DiagnosticEngine::runLink(NetworkMetrics& m, const SystemConfig& cfg) {
+    sampleLink(m);
+    return true;
+}
+
+bool DiagnosticEngine::runNoise(NetworkMetrics& m, const SystemConfig& cfg) {
+    sampleNoise(m);
+    return true;
+}
+
+bool DiagnosticEngine::runScan(NetworkMetrics& m, const SystemConfig& cfg) {
+    return scanNeighbors(m);
+}
+
+bool DiagnosticEngine::runLatency(NetworkMetrics& m, const SystemConfig& cfg) {
+    measureLatency(m, cfg.probeTargets, cfg.pingCount, cfg.pingIntervalMs);
+    return true;
+}
+
+bool DiagnosticEngine::runPath(NetworkMetrics& m, const SystemConfig& cfg) {
+    probePath(m, cfg);
+    return true;
+}
+
+bool DiagnosticEngine::runDns(NetworkMetrics& m, const SystemConfig& cfg) {
+    measureDNS(m, cfg);
+    return true;
+}
+
+bool DiagnosticEngine::runHttp(NetworkMetrics& m, const SystemConfig& cfg) {
+    measureHttp(m, cfg);
+    return true;
+}
+
+bool DiagnosticEngine::pathEnabled(const SystemConfig& cfg) {
+    return cfg.pathProbe;
+}
+
+bool DiagnosticEngine::httpEnabled(const SystemConfig& cfg) {
+    return cfg.httpUrls[0] != '\0';
+}
+
+// 1. Physical Layer Connection Stats
+void DiagnosticEngine::sampleLink(NetworkMetrics& m) {
+    m.rssi = WiFi.RSSI();
+    strncpy(m.bssid, WiFi.BSSIDstr().c_str(), sizeof(m.bssid) - 1);
+    m.bssid[sizeof(m.bssid) - 1] = '\0';
+    m.channel = WiFi.channel();
+    m.reconnectMs = ConnectionManager::lastReconnectMs();
+    m.reconnectCount = ConnectionManager::reconnectCount();
+    m.reconnectFast = ConnectionManager::lastReconnectFast();
+    m.roamCount = LinkMonitor::roamCount();
+}
+
+// 1b. Noise floor: a short promiscuous capture while staying associated
+// refreshes the rolling estimate; SNR comes from it, not a constant.
+void DiagnosticEngine::sampleNoise(NetworkMetrics& m) {
+    SnifferEngine::sampleNoiseFloor(NOISE_SAMPLE_MS);
+    if (NoiseFloorEstimator::valid()) {
+        m.noiseFloor = NoiseFloorEstimator::median();
+        m.snr = (float)m.rssi - m.noiseFloor;
+    } else {
+        m.noiseFloor = 0;
+        m.snr = 0;
+    }
+}
+
+// 2. Neighbor Scan & Congestion Analysis
+// Advances the rolling scan by one channel subset; returns true once the
+// subset is done and the counts have been taken from the neighbor table.
+bool DiagnosticEngine::scanNeighbors(NetworkMetrics& m) {
+    if (!NeighborScanner::step()) return false;
+
+    int n = NeighborScanner::neighborCount();
+    int overlapping = NeighborScanner::overlappingCount(m.channel);
+
+    m.neighborCount = n;
+    m.overlappingCount = overlapping;
+    m.congestion = calculateCongestion(n, overlapping);
+    return true;
+}
+
+// 3. Performance Tests (ICMP echo to every target at once)
+// targetList is comma separated; "gateway", "dns1" and "dns2" resolve to
+// the current DHCP lease. Headline latency/loss come from the first
+// non-local target (the external anchor), falling back to the first one.
+// The gateway is always probed alongside, listed or not, for the LAN/WAN split.
+void DiagnosticEngine::measureLatency(NetworkMetrics& m, const char* targetList, int count, int intervalMs) {
+    uint32_t ips[MAX_PROBE_TARGETS + 1];
+    LatencyStats stats[MAX_PROBE_TARGETS + 1];
+    int probeIndex[MAX_PROBE_TARGETS + 1];
+    int probeCount = 0;
+    IcmpConfig cfg = { count, intervalMs, 1000 };
+
+    m.targetCount = 0;
+    const char* p = targetList;
+    while (*p && m.targetCount < MAX_PROBE_TARGETS) {
+        const char* end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && *p == ' ') { p++; len--; }
+        while (len > 0 && p[len - 1] == ' ') len--;
+
+        if (len > 0 && len < PROBE_TARGET_LEN) {
+            TargetResult& t = m.targets[m.targetCount];
+            memcpy(t.label, p, len);
+            t.label[len] = '\0';
+            t.stats = computeLatencyStats(NULL, 0);
+
+            if (resolveTarget(t.label, t.ip)) {
+                ips[probeCount] = t.ip;
+                probeIndex[probeCount] = m.targetCount;
+                probeCount++;
+            } else {
+                t.ip = 0;
+                Serial.printf("[DIAG] Could not resolve target %s\n", t.label);
+            }
+            m.targetCount++;
         }
+
+        if (!end) break;
+        p = end + 1;
     }
-    metrics.overlappingCount = overlapping;
-    metrics.congestion = calculateCongestion(n, overlapping);
 
-    // 3. Performance Tests (Ping & DNS)
-    bool success = Ping.ping(targetHost, 5);
-    if (success) {
-        metrics.avgLatency = Ping.averageTime();
-        metrics.packetLoss = (Ping.averageTime() > 0) ? 0.0 : 100.0; 
-    } else {
-        metrics.avgLatency = -1;
-        metrics.packetLoss = 100.0;
+    uint32_t gateway = (uint32_t)WiFi.gatewayIP();
+    int gatewayProbe = -1;
+    for (int i = 0; i < probeCount; i++) {
+        if (ips[i] == gateway) gatewayProbe = i;
+    }
+    if (gatewayProbe < 0 && gateway != 0) {
+        ips[probeCount] = gateway;
+        probeIndex[probeCount] = -1;   // not a configured target
+        gatewayProbe = probeCount++;
     }
-    
-    metrics.dnsResolutionTime = measureDNS("google.com");
 
-    return metrics;
+    if (probeCount > 0 && IcmpEngine::pingMany(ips, probeCount, cfg, stats) == 0) {
+        Serial.println("[DIAG] ICMP sockets unavailable");
+    }
+    for (int i = 0; i < probeCount; i++) {
+        if (probeIndex[i] >= 0) m.targets[probeIndex[i]].stats = stats[i];
+    }
+
+    int primary = -1;
+    for (int i = 0; i < m.targetCount && primary < 0; i++) {
+        if (!isLocalTarget(m.targets[i].label)) primary = i;
+    }
+    if (primary < 0 && m.targetCount > 0) primary = 0;
+
+    LatencyStats headline = primary >= 0 ? m.targets[primary].stats : computeLatencyStats(NULL, 0);
+    m.packetLoss = headline.lossPct;
+    m.avgLatency = headline.received > 0 ? (int)(headline.avgMs + 0.5f) : -1;
+    m.minLatency = headline.minMs;
+    m.maxLatency = headline.maxMs;
+    m.p50Latency = headline.p50Ms;
+    m.p95Latency = headline.p95Ms;
+    m.jitter = headline.jitterMs;
+
+    splitLanWan(m, gatewayProbe >= 0 ? &stats[gatewayProbe] : nullptr, primary);
+}
+
+// Medians, since one slow reply on either side would skew a difference of means
+void DiagnosticEngine::splitLanWan(NetworkMetrics& m, const LatencyStats* lan, int primary) {
+    m.lanRtt = lan && lan->received > 0 ? lan->p50Ms : -1;
+    m.lanLoss = lan ? lan->lossPct : -1;
+
+    m.wanRtt = -1;
+    if (primary >= 0 && !isLocalTarget(m.targets[primary].label) &&
+        m.targets[primary].stats.received > 0) {
+        m.wanRtt = m.targets[primary].stats.p50Ms;
+    }
+    m.wanDelta = m.lanRtt >= 0 && m.wanRtt >= 0 ? m.wanRtt - m.lanRtt : 0;
+}
+
+bool DiagnosticEngine::resolveTarget(const char* host, uint32_t& ip) {
+    IPAddress addr;
+    if (strcmp(host, "gateway") == 0) {
+        addr = WiFi.gatewayIP();
+    } else if (strcmp(host, "dns1") == 0 || strcmp(host, "dns") == 0) {
+        addr = WiFi.dnsIP(0);
+    } else if (strcmp(host, "dns2") == 0) {
+        addr = WiFi.dnsIP(1);
+    } else if (!addr.fromString(host) && !WiFi.hostByName(host, addr)) {
+        return false;
+    }
+    ip = (uint32_t)addr;
+    return ip != 0;
+}
+
+bool DiagnosticEngine::isLocalTarget(const char* label) {
+    return strcmp(label, "gateway") == 0 || strcmp(label, "dns") == 0 ||
+           strcmp(label, "dns1") == 0 || strcmp(label, "dns2") == 0;
 }
 
 /**
@@ -48,31 +256,24 @@ NetworkMetrics DiagnosticEngine::performFullTest(const char* targetHost) {
  * Operation Order:
  * 1. Gather basic metrics (while connected)
  * 2. Measure TCP throughput (requires connection)
- * 3. Enter promiscuous mode for radio analysis (disconnects WiFi)
+ * 3. Promiscuous capture on the associated channel (link stays up)
+ * 3b. Optional off-channel sweep (disconnects WiFi)
  * 4. Calculate final metrics
  * 
- * NOTE: WiFi will be DISCONNECTED after this function completes.
- * The caller MUST handle reconnection.
+ * NOTE: only a sweep drops the link. The caller should check WiFi.status()
+ * and reconnect if em.linkKept is false.
  */
-EnhancedMetrics DiagnosticEngine::performDeepAnalysis(const char* targetHost) {
+EnhancedMetrics DiagnosticEngine::performDeepAnalysis(const char* targetList, bool sweep, bool path) {
     Serial.println("\n[DEEP] ══════════════════════════════════════");
     Serial.println("[DEEP] ║ DEEP SCAN INITIATED");
     
     // PHASE 1: Gather metrics while connected
     Serial.println("[DEEP] ║ Phase 1: Gathering basic metrics...");
-    NetworkMetrics basic = performFullTest(targetHost);
+    NetworkMetrics basic = performFullTest(targetList);
     EnhancedMetrics em;
     
     // Copy base metrics to enhanced structure
-    em.rssi = basic.rssi;
-    em.bssid = basic.bssid;
-    em.channel = basic.channel;
-    em.packetLoss = basic.packetLoss;
-    em.avgLatency = basic.avgLatency;
-    em.dnsResolutionTime = basic.dnsResolutionTime;
-    em.neighborCount = basic.neighborCount;
-    em.overlappingCount = basic.overlappingCount;
-    em.congestion = basic.congestion;
+    static_cast<NetworkMetrics&>(em) = basic;
     
     Serial.printf("[DEEP] ║  RSSI: %d dBm\n", em.rssi);
     Serial.printf("[DEEP] ║  Channel: %d\n", em.channel);
@@ -81,8 +282,9 @@ EnhancedMetrics DiagnosticEngine::performDeepAnalysis(const char* targetHost) {
     
     // PHASE 2: Measure TCP throughput (BEFORE promiscuous mode)
     Serial.println("[DEEP] ║ Phase 2: Measuring TCP throughput...");
-    em.tcpThroughput = measureThroughput(targetHost);
-    Serial.printf("[DEEP] ║  Throughput: %d kbps\n", em.tcpThroughput);
+    measureThroughput(em, ConfigManager::load());
+    Serial.printf("[DEEP] ║  Throughput: %d kbps down, %d kbps up\n",
+                  em.tcpThroughput, em.uploadThroughput);
     
     // Get PHY mode while still connected
     uint8_t protocol;
@@ -92,24 +294,60 @@ EnhancedMetrics DiagnosticEngine::performDeepAnalysis(const char* targetHost) {
     else em.phyMode = "802.11b";
     
     em.uptime = millis() / 1000;
+
+    // Phase 1's cycle may already have re-traced the same target
+    if (path && !em.pathFresh) {
+        Serial.println("[DEEP] ║ Phase 2b: Tracing WAN path...");
+        em.pathFresh = tracePath(NULL, ConfigManager::load().pathMaxHops, em.path);
+    }
+    if (path && em.pathFresh) {
+        Serial.printf("[DEEP] ║  Path: %d hops%s\n", em.path.hopCount,
+                      em.path.reached ? "" : " (target not reached)");
+    }
     
-    // PHASE 3: Radio environment analysis (will disconnect WiFi)
+    // PHASE 3: Radio environment analysis on our own channel, still associated
     Serial.println("[DEEP] ║ Phase 3: Radio environment capture...");
-    Serial.println("[DEEP] ║   WARNING: Entering promiscuous mode");
-    Serial.println("[DEEP] ║   WiFi will disconnect temporarily");
     
-    SnifferStats s = SnifferEngine::analyzeChannel(em.channel, 2000);
+    SnifferStats s = SnifferEngine::analyzeChannel(em.channel, 2000, SNIFF_ASSOCIATED);
     
     em.channelUtilization = s.channelUtilization;
-    Serial.printf("[DEEP] ║  Channel utilization: %.1f%%\n", em.channelUtilization);
+    em.mgmtUtilization = s.mgmtBusyPct;
+    em.ctrlUtilization = s.ctrlBusyPct;
+    em.dataUtilization = s.dataBusyPct;
+    Serial.printf("[DEEP] ║  Channel utilization: %.1f%% (mgmt %.1f, ctrl %.1f, data %.1f)\n",
+                  em.channelUtilization, em.mgmtUtilization, em.ctrlUtilization, em.dataUtilization);
     Serial.printf("[DEEP] ║  Beacons: %d (Missed: %d)\n", 
                   s.beaconCount, s.missedBeacons);
-    Serial.printf("[DEEP] ║  Data packets: %d\n", s.dataPackets);
+
+    em.ownBeaconLoss = s.ownApSeen ? s.ownAp.lossPct : -1;
+    em.neighborBeaconLoss = s.neighborBeaconLossPct;
+    em.beaconApCount = s.neighborCount;
+    memcpy(em.beaconAps, s.neighbors, sizeof(ApBeaconStats) * s.neighborCount);
+    Serial.printf("[DEEP] ║  Beacon loss: own AP %.1f%%, %d neighbors %.1f%%\n",
+                  em.ownBeaconLoss, s.neighborApCount, em.neighborBeaconLoss);
+
+    em.sweep.count = 0;
+    if (sweep) {
+        Serial.println("[DEEP] ║ Phase 3b: Sweeping channels 1-13...");
+        Serial.println("[DEEP] ║   WARNING: WiFi will disconnect temporarily");
+        em.sweep = SnifferEngine::sweepChannels(SnifferEngine::defaultSchedule());
+        for (int i = 0; i < em.sweep.count; i++) {
+            const ChannelUsage& u = em.sweep.channels[i];
+            Serial.printf("[DEEP] ║  ch%2d: %5.1f%% util, %d APs, %.1f%% beacon loss\n",
+                          u.channel, u.utilization, u.apCount, u.beaconLossPct);
+        }
+    }
+    Serial.printf("[DEEP] ║  Frames: %d (mgmt %d, ctrl %d, data %d, retry %d, dropped %u)\n",
+                  s.totalFrames, s.mgmtFrames, s.ctrlFrames, s.dataPackets,
+                  s.retryFrames, s.droppedFrames);
     
     // PHASE 4: Calculate derived metrics
     Serial.println("[DEEP] ║ Phase 4: Calculating quality scores...");
-    em.noiseFloor = -95;
-    em.snr = (float)em.rssi - em.noiseFloor;
+    // Prefer this capture's own reading; otherwise keep the phase 1 estimate
+    if (s.associated && s.noiseSamples > 0) {
+        em.noiseFloor = s.noiseFloor;
+    }
+    em.snr = em.noiseFloor != 0 ? (float)em.rssi - em.noiseFloor : 0;
     
     // Link Quality Score (0-100)
     float quality = (em.rssi + 100) * 2; 
@@ -117,149 +355,64 @@ EnhancedMetrics DiagnosticEngine::performDeepAnalysis(const char* targetHost) {
     quality -= (em.channelUtilization * 0.2);
     em.linkQuality = constrain(quality, 0, 100);
     
-    Serial.printf("[DEEP] ║  SNR: %.1f dB\n", em.snr);
+    Serial.printf("[DEEP] ║  Noise floor: %d dBm, SNR: %.1f dB\n", em.noiseFloor, em.snr);
     Serial.printf("[DEEP] ║  Link Quality: %.1f/100\n", em.linkQuality);
+    em.linkKept = WiFi.isConnected();
     Serial.println("[DEEP] ║ DEEP SCAN COMPLETED");
-    Serial.println("[DEEP] ║ WiFi is DISCONNECTED");
-    Serial.println("[DEEP] ║ Caller must reconnect");
+    if (!em.linkKept) {
+        Serial.println("[DEEP] ║ WiFi is DISCONNECTED");
+        Serial.println("[DEEP] ║ Caller must reconnect");
+    }
     return em;
 }
 
-int DiagnosticEngine::measureThroughput(const char* host) {
-    Serial.println("[DIAG] Measuring TCP throughput...");
-    
-    // Pre-check: Ensure WiFi is connected
+/**
+ * Bulk download, then a POST upload, each only when its URL is set. Both
+ * run for tput_duration ms or tput_bytes, whichever comes first, and report
+ * goodput with the first THROUGHPUT_WARMUP_MS excluded. A run that failed,
+ * moved nothing after warm-up or was not configured reports 0.
+ */
+void DiagnosticEngine::measureThroughput(EnhancedMetrics& em, const SystemConfig& cfg) {
+    em.tcpThroughput = 0;
+    em.uploadThroughput = 0;
+
     if (WiFi.status() != WL_CONNECTED) {
         Serial.println("[DIAG]  WiFi not connected, skipping throughput test");
-        return 0;
+        return;
     }
-    
-    const int NUM_ATTEMPTS = 3;
-    int results[NUM_ATTEMPTS];
-    int validResults = 0;
-    
-    for (int attempt = 0; attempt < NUM_ATTEMPTS; attempt++) {
-        // Double-check connection before each attempt
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.printf("[DIAG] Attempt %d/%d: WiFi disconnected, aborting\n", 
-                          attempt + 1, NUM_ATTEMPTS);
-            results[attempt] = -1;
-            break;
-        }
-        
-        WiFiClient client;
-        const int port = 80;
-        const int testDataSize = 8192; // 8KB test
-        
-        Serial.printf("[DIAG] Attempt %d/%d...\n", attempt + 1, NUM_ATTEMPTS);
-        
-        // Try to connect
-        if (!client.connect(host, port, 3000)) {
-            Serial.println("[DIAG] Connection failed");
-            results[attempt] = -1;
-            continue;
-        }
-        
-        // Send HTTP GET request
-        String request = "GET / HTTP/1.1\r\n";
-        request += "Host: ";
-        request += host;
-        request += "\r\n";
-        request += "Connection: close\r\n\r\n";
-        
-        unsigned long startTime = millis();
-        client.print(request);
-        
-        // Wait for response headers
-        while (client.connected() && !client.available()) {
-            if (millis() - startTime > 3000) break;
-            delay(1);
-        }
-        
-        // Skip headers to get to body
-        bool headersComplete = false;
-        unsigned long headerTimeout = millis();
-        while (client.connected() || client.available()) {
-            if (client.available()) {
-                String line = client.readStringUntil('\n');
-                if (line == "\r" || line == "") {
-                    headersComplete = true;
-                    break;
-                }
-                headerTimeout = millis();
-            }
-            if (millis() - headerTimeout > 2000) break;
-        }
-        
-        if (!headersComplete) {
-            Serial.println("[DIAG] Failed to read headers");
-            client.stop();
-            results[attempt] = -1;
-            continue;
-        }
-        
-        // Measure body download speed
-        unsigned long dataStartTime = millis();
-        int totalBytes = 0;
-        unsigned long lastByteTime = millis();
-        
-        while (client.connected() || client.available()) {
-            if (client.available()) {
-                char c = client.read();
-                totalBytes++;
-                lastByteTime = millis();
-            }
-            
-            // Stop conditions
-            if (totalBytes >= testDataSize) break;
-            if (millis() - lastByteTime > 2000) break;
-        }
-        
-        unsigned long dataEndTime = millis();
-        client.stop();
-        
-        if (totalBytes == 0) {
-            Serial.println("[DIAG] No data received");
-            results[attempt] = -1;
-            continue;
+
+    ThroughputConfig tcfg = { cfg.tputDurationMs, (long)cfg.tputBytes, THROUGHPUT_WARMUP_MS, 3000 };
+    HttpUrl url;
+    uint32_t ip;
+    ThroughputResult r;
+
+    if (cfg.tputUrl[0] != '\0') {
+        if (!parseHttpUrl(cfg.tputUrl, url) || url.tls) {
+            Serial.printf("[DIAG] Unsupported throughput URL: %s\n", cfg.tputUrl);
+        } else if (!resolveTarget(url.host, ip)) {
+            Serial.printf("[DIAG] Could not resolve %s\n", url.host);
+        } else if (ThroughputEngine::download(ip, url, tcfg, r) && r.goodputKbps > 0) {
+            em.tcpThroughput = (int)r.goodputKbps;
+            Serial.printf("[DIAG] Download: %ld bytes, %ld in %u ms after warm-up = %d kbps\n",
+                          r.bytes, r.measuredBytes, r.measuredMs, em.tcpThroughput);
+        } else {
+            Serial.printf("[DIAG] Download failed (HTTP %d)\n", r.status);
         }
-        
-        // Calculate throughput
-        float durationSec = (dataEndTime - dataStartTime) / 1000.0;
-        if (durationSec <= 0) durationSec = 0.001;
-        
-        float bytesPerSec = totalBytes / durationSec;
-        int kbps = (int)((bytesPerSec * 8) / 1024);
-        
-        Serial.printf("[DIAG] Attempt %d: %d bytes in %.2fs = %d kbps\n", 
-                      attempt + 1, totalBytes, durationSec, kbps);
-        
-        results[attempt] = kbps;
-        validResults++;
-        
-        delay(100);
-    }
-    
-    // Calculate average of valid results
-    if (validResults == 0) {
-        Serial.println("[DIAG] All throughput attempts failed");
-        return 0;
     }
-    
-    int sum = 0;
-    int count = 0;
-    for (int i = 0; i < NUM_ATTEMPTS; i++) {
-        if (results[i] > 0) {
-            sum += results[i];
-            count++;
-        }
+
+    if (cfg.tputUploadUrl[0] == '\0') return;
+
+    if (!parseHttpUrl(cfg.tputUploadUrl, url) || url.tls) {
+        Serial.printf("[DIAG] Unsupported upload URL: %s\n", cfg.tputUploadUrl);
+    } else if (!resolveTarget(url.host, ip)) {
+        Serial.printf("[DIAG] Could not resolve %s\n", url.host);
+    } else if (ThroughputEngine::upload(ip, url, tcfg, r) && r.goodputKbps > 0) {
+        em.uploadThroughput = (int)r.goodputKbps;
+        Serial.printf("[DIAG] Upload: %ld bytes, %ld in %u ms after warm-up = %d kbps\n",
+                      r.bytes, r.measuredBytes, r.measuredMs, em.uploadThroughput);
+    } else {
+        Serial.println("[DIAG] Upload failed");
     }
-    
-    int avgKbps = count > 0 ? sum / count : 0;
-    Serial.printf("[DIAG Average throughput: %d kbps (%d/%d valid)\n", 
-                  avgKbps, validResults, NUM_ATTEMPTS);
-    
-    return avgKbps;
 }
 
 CongestionRating DiagnosticEngine::calculateCongestion(int total, int overlapping) {
@@ -268,11 +421,269 @@ CongestionRating DiagnosticEngine::calculateCongestion(int total, int overlappin
     return GOOD;
 }
 
-int DiagnosticEngine::measureDNS(const char* host) {
-    unsigned long start = millis();
-    IPAddress remote_ip;
-    if (WiFi.hostByName(host, remote_ip)) {
-        return (int)(millis() - start);
+/**
+ * Queries every configured resolver directly over UDP. dnsResolutionTime
+ * keeps its meaning (ms, -1 on failure) and reports the first resolver's
+ * median so existing dashboards continue to work. Lease names (dns1,
+ * dns2) the DHCP server left unset are skipped, not reported.
+ */
+void DiagnosticEngine::measureDNS(NetworkMetrics& m, const SystemConfig& cfg) {
+    uint32_t ips[DNS_MAX_RESOLVERS];
+    ResolverStats stats[DNS_MAX_RESOLVERS];
+    int probeIndex[DNS_MAX_RESOLVERS];
+    int probeCount = 0;
+    DnsQueryConfig dnsCfg = { cfg.dnsQueries, 100, 2000, cfg.dnsZone, cfg.dnsNames };
+
+    m.resolverCount = 0;
+    String list = String(cfg.dnsResolvers);
+    int start = 0;
+    while (start <= (int)list.length() && m.resolverCount < DNS_MAX_RESOLVERS) {
+        int end = list.indexOf(',', start);
+        if (end < 0) end = list.length();
+        String item = list.substring(start, end);
+        item.trim();
+        start = end + 1;
+        if (item.length() == 0 || item.length() >= RESOLVER_LABEL_LEN) continue;
+
+        uint32_t ip = 0;
+        bool resolved = resolveTarget(item.c_str(), ip);
+        // Most leases carry one DNS server; an unset dns2 is not a failure
+        if (!resolved && isLocalTarget(item.c_str())) continue;
+
+        ResolverResult& r = m.resolvers[m.resolverCount];
+        strncpy(r.label, item.c_str(), sizeof(r.label));
+        memset(&r.stats, 0, sizeof(r.stats));
+        r.stats.latency = computeLatencyStats(NULL, 0);
+        r.ip = resolved ? ip : 0;
+
+        if (resolved) {
+            ips[probeCount] = r.ip;
+            probeIndex[probeCount] = m.resolverCount;
+            probeCount++;
+        } else {
+            Serial.printf("[DIAG] Could not resolve DNS resolver %s\n", r.label);
+        }
+        m.resolverCount++;
+    }
+
+    if (probeCount > 0 && DnsEngine::measure(ips, probeCount, dnsCfg, stats) == 0) {
+        Serial.println("[DIAG] DNS sockets unavailable");
     }
-    return -1;
-}
\ No newline at end of file
+    for (int i = 0; i < probeCount; i++) {
+        m.resolvers[probeIndex[i]].stats = stats[i];
+    }
+
+    m.dnsResolutionTime = -1;
+    if (m.resolverCount > 0 && m.resolvers[0].stats.answered > 0) {
+        m.dnsResolutionTime = (int)(m.resolvers[0].stats.latency.p50Ms + 0.5f);
+    }
+}
+
+/**
+ * Timed GET to every configured URL in turn: DNS, connect, TLS, first
+ * byte and transfer each reported separately. Nothing runs when the list
+ * is empty.
+ */
+void DiagnosticEngine::measureHttp(NetworkMetrics& m, const SystemConfig& cfg) {
+    HttpProbeConfig httpCfg = { HTTP_PROBE_TIMEOUT_MS, HTTP_PROBE_MAX_BYTES };
+
+    m.httpCount = 0;
+    String list = String(cfg.httpUrls);
+    int start = 0;
+    while (start < (int)list.length() && m.httpCount < MAX_HTTP_URLS) {
+        int end = list.indexOf(',', start);
+        if (end < 0) end = list.length();
+        String item = list.substring(start, end);
+        item.trim();
+        start = end + 1;
+        if (item.length() == 0) continue;
+
+        HttpResult& r = m.http[m.httpCount++];
+        int scheme = item.indexOf("://");
+        String label = scheme >= 0 ? item.substring(scheme + 3) : item;
+        strncpy(r.label, label.c_str(), sizeof(r.label) - 1);
+        r.label[sizeof(r.label) - 1] = '\0';
+
+        if (!HttpTimingProbe::run(item.c_str(), httpCfg, r.timing)) {
+            Serial.printf("[DIAG] HTTP probe %s failed in phase %d\n", r.label, r.timing.failedPhase);
+        }
+        // The handshake is the deepest the measurement task's stack goes
+        if (item.startsWith("https://")) {
+            Serial.printf("[DIAG] Stack headroom after TLS: %u bytes\n",
+                          (unsigned)uxTaskGetStackHighWaterMark(NULL));
+        }
+    }
+}
+
+// First non-local entry of a probe target list, resolved
+bool DiagnosticEngine::pathTarget(const char* targetList, uint32_t& ip) {
+    String list = String(targetList);
+    int start = 0;
+    while (start < (int)list.length()) {
+        int end = list.indexOf(',', start);
+        if (end < 0) end = list.length();
+        String item = list.substring(start, end);
+        item.trim();
+        start = end + 1;
+        if (item.length() == 0 || isLocalTarget(item.c_str())) continue;
+        if (resolveTarget(item.c_str(), ip)) return true;
+    }
+    return false;
+}
+
+bool DiagnosticEngine::tracePath(const char* target, int maxHops, PathResult& out) {
+    uint32_t ip;
+    bool resolved = (target && *target) ? resolveTarget(target, ip)
+                                        : pathTarget(ConfigManager::getProbeTargets().c_str(), ip);
+    if (!resolved) {
+        memset(&out, 0, sizeof(out));
+        return false;
+    }
+
+    return traceTo(ip, maxHops, out, -1);
+}
+
+/**
+ * Every trace refreshes the cache and the RTT it is compared against.
+ * Without a cycle's WAN RTT (commands, deep scans) the baseline is the
+ * trace's own RTT to the destination, or unset when it was not reached.
+ */
+bool DiagnosticEngine::traceTo(uint32_t ip, int maxHops, PathResult& out, float wanRtt) {
+    PathProbeConfig cfg = { maxHops, PATH_PROBES_PER_HOP, 50, 1000 };
+    if (!PathProbe::trace(ip, cfg, out)) return false;
+    cachedPath = out;
+    pathCached = true;
+    pathTracedAt = millis();
+    if (wanRtt < 0 && out.reached && out.hopCount > 0) {
+        wanRtt = out.hops[out.hopCount - 1].rttMs;
+    }
+    pathBaselineRtt = wanRtt;
+    return true;
+}
+
+/**
+ * Path tracing is cheap (one timeout for all hops) but still the noisiest
+ * thing we send, so a cycle only re-traces when there is no path yet, it
+ * is over an hour old, the WAN target changed, or WAN RTT moved materially.
+ */
+void DiagnosticEngine::probePath(NetworkMetrics& m, const SystemConfig& cfg) {
+    m.pathFresh = false;
+    if (!cfg.pathProbe) return;
+
+    // Same external target the latency phase already resolved
+    uint32_t ip = 0;
+    for (int i = 0; i < m.targetCount && ip == 0; i++) {
+        if (!isLocalTarget(m.targets[i].label)) ip = m.targets[i].ip;
+    }
+    if (ip == 0) return;
+
+    bool stale = !pathCached || cachedPath.target != ip ||
+                 millis() - pathTracedAt > PATH_MAX_AGE_MS;
+    if (!stale && m.wanRtt >= 0) {
+        float moved = fabsf(m.wanRtt - pathBaselineRtt);
+        stale = pathBaselineRtt < 0 ||
+                (moved > PATH_RERUN_MIN_MS && moved > PATH_RERUN_FRACTION * pathBaselineRtt);
+    }
+    if (!stale) return;
+
+    m.pathFresh = traceTo(ip, cfg.pathMaxHops, m.path, m.wanRtt);
+}
+
+void DiagnosticEngine::beginEvents() {
+    if (eventQueue == NULL) {
+        eventQueue = xQueueCreate(EVENT_QUEUE_DEPTH, sizeof(ChangeEvent));
+    }
+}
+
+/**
+ * Feeds one cycle into the detectors. RSSI only comes from here when the
+ * between-cycle sampler produced nothing, so it is not counted twice.
+ * Returns true if any metric degraded.
+ */
+bool DiagnosticEngine::detectChanges(const NetworkMetrics& m, const SystemConfig& cfg) {
+    bool degraded = false;
+    if (m.rssiSamples.count == 0) {
+        degraded |= observe(CHANGE_RSSI, m.rssi, cfg);
+    }
+    if (m.avgLatency >= 0) {
+        degraded |= observe(CHANGE_LATENCY, m.avgLatency, cfg);
+    }
+    if (m.targetCount > 0) {
+        degraded |= observe(CHANGE_LOSS, m.packetLoss, cfg);
+    }
+    if (m.dnsResolutionTime >= 0) {
+        degraded |= observe(CHANGE_DNS, m.dnsResolutionTime, cfg);
+    }
+    return degraded;
+}
+
+/**
+ * Runs one sample through its detector and queues an event on a shift.
+ * A degradation may also queue an automatic deep scan, at most one per
+ * autoScanGapS; loop() picks it up with takeAutoScanRequest().
+ */
+bool DiagnosticEngine::observe(ChangeMetric metric, float value, const SystemConfig& cfg) {
+    if (!cfg.eventDetect) return false;
+
+    ChangeDetector& d = detectors[metric];
+    float baseline = d.mean();
+    float sigma = d.sigma();
+    int shift = d.add(value);
+    if (shift == 0) return false;
+
+    ChangeEvent ev;
+    ev.metric = metric;
+    ev.direction = shift;
+    // Weaker signal is bad; for everything else higher is worse
+    ev.degraded = metric == CHANGE_RSSI ? shift < 0 : shift > 0;
+    ev.value = value;
+    ev.baseline = baseline;
+    ev.sigma = sigma;
+    ev.deepScan = false;
+
+    if (ev.degraded && cfg.autoDeepScan && !autoScanPending &&
+        (!autoScanRan || millis() - lastAutoScan > cfg.autoScanGapS * 1000UL)) {
+        autoScanMetric = metric;
+        autoScanPending = true;
+        autoScanRan = true;
+        lastAutoScan = millis();
+        ev.deepScan = true;
+    }
+
+    Serial.printf("[DIAG] Change on %s: %.1f -> %.1f%s\n", changeMetricName(metric),
+                  baseline, value, ev.deepScan ? " (deep scan queued)" : "");
+
+    if (eventQueue != NULL && xQueueSend(eventQueue, &ev, 0) != pdTRUE) {
+        Serial.println("[DIAG] ⚠ Event queue full, event dropped");
+    }
+    return ev.degraded;
+}
+
+/**
+ * True when every metric measured this cycle sits inside its detector's
+ * variance band. A detector still learning its baseline counts as unstable.
+ * Call it before detectChanges(), which folds the cycle into the baseline.
+ */
+bool DiagnosticEngine::isStable(const NetworkMetrics& m) {
+    float rssi = m.rssiSamples.count > 0 ? m.rssiSamples.mean : m.rssi;
+    if (!detectors[CHANGE_RSSI].within(rssi, STABILITY_BAND_SIGMAS)) return false;
+    if (m.avgLatency >= 0 &&
+        !detectors[CHANGE_LATENCY].within(m.avgLatency, STABILITY_BAND_SIGMAS)) return false;
+    if (m.targetCount > 0 &&
+        !detectors[CHANGE_LOSS].within(m.packetLoss, STABILITY_BAND_SIGMAS)) return false;
+    if (m.dnsResolutionTime >= 0 &&
+        !detectors[CHANGE_DNS].within(m.dnsResolutionTime, STABILITY_BAND_SIGMAS)) return false;
+    return true;
+}
+
+bool DiagnosticEngine::nextEvent(ChangeEvent& out) {
+    if (eventQueue == NULL) return false;
+    return xQueueReceive(eventQueue, &out, 0) == pdTRUE;
+}
+
+bool DiagnosticEngine::takeAutoScanRequest(uint8_t& metric) {
+    if (!autoScanPending) return false;
+    metric = autoScanMetric;
+    autoScanPending = false;
+    return true;
+}
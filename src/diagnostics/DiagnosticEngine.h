@@ -3,42 +3,176 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <ESP32Ping.h>
 #include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "LatencyStats.h"
+#include "StreamingStats.h"
+#include "ChangeDetector.h"
+#include "DnsEngine.h"
+#include "HttpTimingProbe.h"
+#include "PathProbe.h"
+#include "BeaconTracker.h"
+#include "SnifferEngine.h"
+#include "../storage/ConfigManager.h"
+
+#define MAX_PROBE_TARGETS 6
+#define PROBE_TARGET_LEN 48
+#define RESOLVER_LABEL_LEN 24
+#define THROUGHPUT_WARMUP_MS 500
+#define NOISE_SAMPLE_MS 150
+#define EVENT_QUEUE_DEPTH 8
+#define STABILITY_BAND_SIGMAS 2.0f
+#define MAX_HTTP_URLS 3
+#define HTTP_LABEL_LEN 64
+#define HTTP_PROBE_TIMEOUT_MS 5000
+#define HTTP_PROBE_MAX_BYTES 65536
+#define PATH_RERUN_MIN_MS 20          // WAN RTT must move by this much...
+#define PATH_RERUN_FRACTION 0.5f      // ...and by this share of the old value
+#define PATH_MAX_AGE_MS 3600000UL     // re-trace at least hourly
+#define PATH_PROBES_PER_HOP 2
 
 enum CongestionRating { GOOD, BAD, TERRIBLE };
 
+struct TargetResult {
+    char label[PROBE_TARGET_LEN];   // as configured: "gateway", "dns1", host or IP
+    uint32_t ip;
+    LatencyStats stats;
+};
+
+struct ResolverResult {
+    char label[RESOLVER_LABEL_LEN];
+    uint32_t ip;
+    ResolverStats stats;
+};
+
+struct HttpResult {
+    char label[HTTP_LABEL_LEN];     // URL without the scheme, truncated
+    HttpTiming timing;
+};
+
+// Plain-old-data so it can be handed between tasks through a FreeRTOS queue.
 struct NetworkMetrics {
     int rssi;
-    String bssid;
+    char bssid[18];
     int channel;
-    float packetLoss;
+    float packetLoss;        // 0-100, fractional
     int avgLatency;
+    float minLatency;
+    float maxLatency;
+    float p50Latency;
+    float p95Latency;
+    float jitter;            // RFC 3550 estimate, ms
+    float lanRtt;            // gateway median RTT, ms; -1 if no reply
+    float lanLoss;
+    float wanRtt;            // headline external target median RTT, ms; -1 if none
+    float wanDelta;          // wanRtt - lanRtt: the share beyond the gateway
     int dnsResolutionTime;
     int neighborCount;
     int overlappingCount;
     CongestionRating congestion;
+    int targetCount;
+    TargetResult targets[MAX_PROBE_TARGETS];
+    int resolverCount;
+    ResolverResult resolvers[DNS_MAX_RESOLVERS];
+    int httpCount;
+    HttpResult http[MAX_HTTP_URLS];
+    bool pathFresh;           // path was traced this cycle; otherwise it is not sent
+    PathResult path;
+    int noiseFloor;           // rolling median of rx_ctrl.noise_floor, dBm; 0 if not yet measured
+    float snr;                // rssi - noiseFloor, only meaningful when noiseFloor != 0
+    SampleSummary rssiSamples;    // high-rate samples over the last interval
+    SampleSummary gwRttSamples;   // gateway RTT, replies only
+    int gwProbesSent;
+    int gwProbesLost;
+    int reconnectMs;          // duration of the last (re)association, -1 if none
+    int reconnectCount;
+    bool reconnectFast;       // last one used the cached BSSID/channel
+    int roamCount;            // BSSID changes since boot
+    int intervalS;            // report interval in force after this cycle
+    uint8_t intervalReason;   // IntervalReason
+    int cycleMs;              // wall time of the cycle, scheduler included
+    uint16_t deferredMask;    // probe modules left out to keep to the budget
 };
 
 struct EnhancedMetrics : NetworkMetrics {
-    float snr;
-    int8_t noiseFloor;
     float linkQuality;       // 0-100 score
-    float channelUtilization; // Estimated %
-    int tcpThroughput;        // kbps
+    float channelUtilization; // Estimated airtime %
+    float mgmtUtilization;    // share of the above by frame type
+    float ctrlUtilization;
+    float dataUtilization;
+    float ownBeaconLoss;      // % of expected beacons missed from our AP, -1 if not heard
+    float neighborBeaconLoss; // pooled over all other APs on the channel
+    int beaconApCount;
+    ApBeaconStats beaconAps[BEACON_MAX_REPORTED];  // strongest neighbors
+    ChannelSweep sweep;       // count 0 unless a sweep was requested
+    int tcpThroughput;        // download goodput, kbps
+    int uploadThroughput;     // upload goodput, kbps (0 if not configured)
     String phyMode;           // 802.11b/g/n
     uint32_t uptime;          // Connection uptime
+    bool linkKept;            // association survived the scan
 };
 
 class DiagnosticEngine {
 public:
-    static NetworkMetrics performFullTest(const char* targetHost);
-    static EnhancedMetrics performDeepAnalysis(const char* targetHost);
+    static NetworkMetrics performFullTest(const char* targetList);
+    static EnhancedMetrics performDeepAnalysis(const char* targetList, bool sweep = false,
+                                               bool path = false);
+    // Puts the measurement phases below into the CycleScheduler registry (once)
+    static void registerModules();
+
+    // Individual measurement phases, driven one at a time by the scheduler
+    static void sampleLink(NetworkMetrics& m);
+    static void sampleNoise(NetworkMetrics& m);
+    static bool scanNeighbors(NetworkMetrics& m);
+    static void measureLatency(NetworkMetrics& m, const char* targetList,
+                               int count = 10, int intervalMs = 200);
+    static bool resolveTarget(const char* host, uint32_t& ip);
+    static void measureDNS(NetworkMetrics& m, const SystemConfig& cfg);
+    static void measureHttp(NetworkMetrics& m, const SystemConfig& cfg);
+    // Re-traces the WAN path only when it is stale or WAN latency moved
+    static void probePath(NetworkMetrics& m, const SystemConfig& cfg);
+    // Unconditional trace; target NULL/empty picks the first external probe target
+    static bool tracePath(const char* target, int maxHops, PathResult& out);
+
+    // Change detection; fed from the measurement task, drained by loop()
+    static void beginEvents();
+    static bool detectChanges(const NetworkMetrics& m, const SystemConfig& cfg);
+    static bool observe(ChangeMetric metric, float value, const SystemConfig& cfg);
+    static bool isStable(const NetworkMetrics& m);
+    static bool nextEvent(ChangeEvent& out);
+    static bool takeAutoScanRequest(uint8_t& metric);
     
 private:
-    static int measureDNS(const char* host);
+    // ProbeModule adapters around the phases above
+    static bool runLink(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool runNoise(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool runScan(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool runLatency(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool runPath(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool runDns(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool runHttp(NetworkMetrics& m, const SystemConfig& cfg);
+    static bool pathEnabled(const SystemConfig& cfg);
+    static bool httpEnabled(const SystemConfig& cfg);
+
+    static bool isLocalTarget(const char* label);
+    static void splitLanWan(NetworkMetrics& m, const LatencyStats* lan, int primary);
+    static bool pathTarget(const char* targetList, uint32_t& ip);
+    static bool traceTo(uint32_t ip, int maxHops, PathResult& out, float wanRtt);
     static CongestionRating calculateCongestion(int neighbors, int overlapping);
-    static int measureThroughput(const char* host);
+    static void measureThroughput(EnhancedMetrics& em, const SystemConfig& cfg);
+
+    static ChangeDetector detectors[CHANGE_METRIC_COUNT];
+    static QueueHandle_t eventQueue;
+    static volatile bool autoScanPending;
+    static volatile uint8_t autoScanMetric;
+    static bool autoScanRan;
+    static unsigned long lastAutoScan;
+
+    static PathResult cachedPath;
+    static bool pathCached;
+    static float pathBaselineRtt;
+    static unsigned long pathTracedAt;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "DnsEngine.h"
+#include <stdio.h>
+
+static int openUdpSocket() {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) return -1;
+    if (!netSetNonBlocking(sock)) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/**
+ * Picks the query name: the index-th entry of the configured name list,
+ * or a fresh 10 character label under the configured zone.
+ */
+void DnsEngine::nextName(const DnsQueryConfig& cfg, int index, char* out, size_t size) {
+    if (cfg.names && cfg.names[0]) {
+        int entries = 1;
+        for (const char* p = cfg.names; *p; p++) {
+            if (*p == ',') entries++;
+        }
+
+        const char* p = cfg.names;
+        for (int skip = index % entries; skip > 0; skip--) {
+            p = strchr(p, ',') + 1;
+        }
+        const char* end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && *p == ' ') { p++; len--; }
+        while (len > 0 && p[len - 1] == ' ') len--;
+        if (len >= size) len = size - 1;
+        memcpy(out, p, len);
+        out[len] = '\0';
+        return;
+    }
+
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    char label[11];
+    for (int i = 0; i < 10; i++) {
+        label[i] = alphabet[netRandom() % (sizeof(alphabet) - 1)];
+    }
+    label[10] = '\0';
+    snprintf(out, size, "%s.%s", label, cfg.zone ? cfg.zone : "google.com");
+}
+
+int DnsEngine::buildQuery(uint8_t* buf, size_t size, uint16_t id, const char* name) {
+    if (size < 12) return -1;
+    memset(buf, 0, 12);
+    buf[0] = id >> 8;
+    buf[1] = id & 0xFF;
+    buf[2] = 0x01;  // RD
+    buf[5] = 0x01;  // QDCOUNT = 1
+
+    size_t pos = 12;
+    const char* label = name;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t len = dot ? (size_t)(dot - label) : strlen(label);
+        if (len == 0 || len > 63 || pos + len + 1 >= size) return -1;
+        buf[pos++] = (uint8_t)len;
+        memcpy(buf + pos, label, len);
+        pos += len;
+        if (!dot) break;
+        label = dot + 1;
+    }
+    if (pos + 5 > size) return -1;
+    buf[pos++] = 0;     // root
+    buf[pos++] = 0;
+    buf[pos++] = 1;     // QTYPE A
+    buf[pos++] = 0;
+    buf[pos++] = 1;     // QCLASS IN
+    return (int)pos;
+}
+
+// Returns the response code, or -1 if this is not a DNS response
+int DnsEngine::parseResponse(const uint8_t* buf, int len, uint16_t* id) {
+    if (len < 12) return -1;
+    if (!(buf[2] & 0x80)) return -1;  // QR bit
+    *id = (uint16_t)((buf[0] << 8) | buf[1]);
+    return buf[3] & 0x0F;
+}
+
+int DnsEngine::measure(const uint32_t* ips, int resolverCount, const DnsQueryConfig& cfg, ResolverStats* out) {
+    int count = cfg.queriesPerResolver;
+    if (count < 1) count = 1;
+    if (count > DNS_MAX_QUERIES) count = DNS_MAX_QUERIES;
+    if (resolverCount > DNS_MAX_RESOLVERS) resolverCount = DNS_MAX_RESOLVERS;
+
+    int socks[DNS_MAX_RESOLVERS];
+    uint16_t baseIds[DNS_MAX_RESOLVERS];
+    float rtts[DNS_MAX_RESOLVERS][DNS_MAX_QUERIES];
+    uint32_t sentAt[DNS_MAX_RESOLVERS][DNS_MAX_QUERIES];
+    bool done[DNS_MAX_RESOLVERS][DNS_MAX_QUERIES];
+    int outstanding = 0;
+    int opened = 0;
+    int maxFd = -1;
+
+    for (int r = 0; r < resolverCount; r++) {
+        memset(&out[r], 0, sizeof(ResolverStats));
+        for (int i = 0; i < count; i++) {
+            rtts[r][i] = -1;
+            done[r][i] = false;
+        }
+        socks[r] = openUdpSocket();
+        baseIds[r] = (uint16_t)netRandom();
+        if (socks[r] < 0) continue;
+        opened++;
+        if (socks[r] > maxFd) maxFd = socks[r];
+    }
+
+    uint32_t start = netMicros();
+    uint32_t intervalUs = (uint32_t)cfg.intervalMs * 1000;
+    uint32_t deadlineUs = (uint32_t)(count - 1) * intervalUs + (uint32_t)cfg.timeoutMs * 1000;
+    int nextQuery = 0;
+
+    while (opened > 0) {
+        uint32_t elapsed = netMicros() - start;
+        if (elapsed >= deadlineUs) break;
+        if (nextQuery >= count && outstanding == 0) break;
+
+        if (nextQuery < count && elapsed >= (uint32_t)nextQuery * intervalUs) {
+            char name[DNS_MAX_NAME_LEN];
+            nextName(cfg, nextQuery, name, sizeof(name));
+
+            for (int r = 0; r < resolverCount; r++) {
+                if (socks[r] < 0) continue;
+                uint8_t query[DNS_MAX_NAME_LEN + 20];
+                int len = buildQuery(query, sizeof(query), (uint16_t)(baseIds[r] + nextQuery), name);
+                if (len < 0) continue;
+
+                struct sockaddr_in to;
+                memset(&to, 0, sizeof(to));
+                to.sin_family = AF_INET;
+                to.sin_port = htons(DNS_PORT_NUMBER);
+                to.sin_addr.s_addr = ips[r];
+
+                sentAt[r][nextQuery] = netMicros();
+                if (sendto(socks[r], query, len, 0, (struct sockaddr*)&to, sizeof(to)) == len) {
+                    out[r].sent++;
+                    outstanding++;
+                }
+            }
+            nextQuery++;
+            continue;
+        }
+
+        uint32_t waitUs = deadlineUs - elapsed;
+        if (nextQuery < count) {
+            uint32_t untilSend = (uint32_t)nextQuery * intervalUs - elapsed;
+            if (untilSend < waitUs) waitUs = untilSend;
+        }
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        for (int r = 0; r < resolverCount; r++) {
+            if (socks[r] >= 0) FD_SET(socks[r], &readSet);
+        }
+        struct timeval tv;
+        tv.tv_sec = waitUs / 1000000;
+        tv.tv_usec = waitUs % 1000000;
+        if (select(maxFd + 1, &readSet, NULL, NULL, &tv) <= 0) continue;
+
+        for (int r = 0; r < resolverCount; r++) {
+            if (socks[r] < 0 || !FD_ISSET(socks[r], &readSet)) continue;
+
+            uint8_t buf[512];
+            struct sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            int len;
+            while ((len = recvfrom(socks[r], buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromLen)) > 0) {
+                uint32_t now = netMicros();
+                uint16_t id;
+                int rcode = parseResponse(buf, len, &id);
+                int q = (uint16_t)(id - baseIds[r]);
+                fromLen = sizeof(from);
+                if (rcode < 0 || from.sin_addr.s_addr != ips[r]) continue;
+                if (q >= nextQuery || done[r][q]) continue;
+
+                done[r][q] = true;
+                outstanding--;
+                if (rcode == DNS_RCODE_NOERROR || rcode == DNS_RCODE_NXDOMAIN) {
+                    rtts[r][q] = (now - sentAt[r][q]) / 1000.0f;
+                    out[r].answered++;
+                } else if (rcode == DNS_RCODE_SERVFAIL) {
+                    out[r].servfail++;
+                } else {
+                    out[r].errors++;
+                }
+            }
+        }
+    }
+
+    for (int r = 0; r < resolverCount; r++) {
+        if (socks[r] >= 0) close(socks[r]);
+        out[r].timeouts = out[r].sent - out[r].answered - out[r].servfail - out[r].errors;
+
+        // Latency percentiles only over answered queries
+        float answered[DNS_MAX_QUERIES];
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            if (rtts[r][i] >= 0) answered[n++] = rtts[r][i];
+        }
+        out[r].latency = computeLatencyStats(answered, n);
+        out[r].latency.sent = out[r].sent;
+        out[r].latency.lossPct = out[r].sent > 0 ? 100.0f * out[r].timeouts / out[r].sent : 100.0f;
+    }
+    return opened;
+}
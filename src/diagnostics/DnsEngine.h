@@ -0,0 +1,50 @@
+#ifndef DNS_ENGINE_H
+#define DNS_ENGINE_H
+
+#include "NetCompat.h"
+#include "LatencyStats.h"
+
+#define DNS_MAX_RESOLVERS 3
+#define DNS_MAX_QUERIES 16
+#define DNS_MAX_NAME_LEN 96
+#define DNS_PORT_NUMBER 53
+
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_SERVFAIL 2
+#define DNS_RCODE_NXDOMAIN 3
+
+struct DnsQueryConfig {
+    int queriesPerResolver;  // capped at DNS_MAX_QUERIES
+    int intervalMs;          // pacing between queries to the same resolver
+    int timeoutMs;           // wait for the last answer
+    const char* zone;        // random labels are prepended to this zone
+    const char* names;       // optional comma separated list used instead
+};
+
+struct ResolverStats {
+    int sent;
+    int answered;    // NOERROR or NXDOMAIN, i.e. the resolver did its job
+    int timeouts;
+    int servfail;
+    int errors;      // REFUSED, FORMERR, ...
+    LatencyStats latency;  // over answered queries only
+};
+
+/**
+ * Minimal UDP DNS client that talks straight to each resolver, bypassing
+ * lwIP's resolver cache. Queries use fresh random labels (or a rotating
+ * name list) so every measurement is a real round trip to the resolver.
+ * All resolvers are queried concurrently and multiplexed with select().
+ */
+class DnsEngine {
+public:
+    // ips are in network byte order
+    static int measure(const uint32_t* ips, int resolverCount, const DnsQueryConfig& cfg, ResolverStats* out);
+
+private:
+    static int buildQuery(uint8_t* buf, size_t size, uint16_t id, const char* name);
+    static int parseResponse(const uint8_t* buf, int len, uint16_t* id);
+    static void nextName(const DnsQueryConfig& cfg, int index, char* out, size_t size);
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include "FrameRing.h"
+
+bool IRAM_ATTR FrameRing::push(const FrameSummary& f) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= FRAME_RING_SIZE) {
+        drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slots[h & (FRAME_RING_SIZE - 1)] = f;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameRing::pop(FrameSummary& f) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    f = slots[t & (FRAME_RING_SIZE - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+// Only safe while the producer is stopped (promiscuous mode off)
+void FrameRing::reset() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    drops.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,73 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// push() runs in the Wi-Fi callback and must be placed in IRAM on the probe
+#ifdef ARDUINO
+#include <esp_attr.h>
+#else
+#define IRAM_ATTR
+#endif
+
+#define FRAME_RING_SIZE 512   // power of two
+
+// FrameSummary.flags
+#define FRAME_FLAG_RETRY    0x01
+#define FRAME_FLAG_TODS     0x02
+#define FRAME_FLAG_FROMDS   0x04
+#define FRAME_FLAG_PROTECTED 0x08
+#define FRAME_FLAG_HT       0x10   // rate holds the HT MCS
+#define FRAME_FLAG_40MHZ    0x20
+#define FRAME_FLAG_SGI      0x40
+#define FRAME_FLAG_AMPDU    0x80
+
+// Frame type from the first frame-control byte
+#define FRAME_TYPE(fc)    (((fc) >> 2) & 0x03)
+#define FRAME_SUBTYPE(fc) (((fc) >> 4) & 0x0F)
+#define FRAME_TYPE_MGMT 0
+#define FRAME_TYPE_CTRL 1
+#define FRAME_TYPE_DATA 2
+
+/**
+ * Compact per-frame record produced by the promiscuous callback.
+ * 28 bytes so the whole ring stays small enough for internal DRAM.
+ */
+struct FrameSummary {
+    uint32_t timestampUs;   // rx_ctrl.timestamp
+    uint32_t addrHash;      // FNV-1a over the address fields present
+    uint16_t len;           // rx_ctrl.sig_len, includes FCS
+    uint16_t seq;           // 802.11 sequence number, 0 for control frames
+    int8_t rssi;
+    uint8_t rate;           // wifi_phy_rate_t, or MCS when FRAME_FLAG_HT
+    uint8_t fc;             // frame control byte 0: type/subtype
+    uint8_t flags;          // FRAME_FLAG_*
+    uint8_t bssid[6];       // from the DS bits; zero for control and WDS frames
+    uint16_t beaconIntervalTu;  // beacons only, 0 otherwise
+    int8_t noiseFloor;      // rx_ctrl.noise_floor, dBm
+};
+
+/**
+ * Single-producer/single-consumer ring. push() is called only from the
+ * Wi-Fi driver callback and never blocks: when the ring is full the frame
+ * is counted in dropped() and discarded. pop() is called only from the
+ * task that owns the capture.
+ */
+class FrameRing {
+public:
+    FrameRing() : head(0), tail(0), drops(0) {}
+
+    bool push(const FrameSummary& f);
+    bool pop(FrameSummary& f);
+    void reset();
+    uint32_t dropped() const { return drops.load(std::memory_order_relaxed); }
+
+private:
+    FrameSummary slots[FRAME_RING_SIZE];
+    std::atomic<uint32_t> head;   // written by the producer
+    std::atomic<uint32_t> tail;   // written by the consumer
+    std::atomic<uint32_t> drops;
+};
+
+#endif
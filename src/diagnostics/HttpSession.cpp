@@ -0,0 +1,341 @@
+#include "HttpSession.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#ifdef ARDUINO
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/net_sockets.h>
+
+struct HttpSession::TlsState {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    int fd;
+};
+
+// BIO callbacks over the non-blocking socket; waiting is done by the caller
+static int tlsSend(void* ctx, const unsigned char* buf, size_t len) {
+    int n = send(*(int*)ctx, buf, len, 0);
+    if (n >= 0) return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE
+                                                     : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int tlsRecv(void* ctx, unsigned char* buf, size_t len) {
+    int n = recv(*(int*)ctx, buf, len, 0);
+    if (n >= 0) return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ
+                                                     : MBEDTLS_ERR_NET_RECV_FAILED;
+}
+#endif
+
+bool parseHttpUrl(const char* url, HttpUrl& out) {
+    memset(&out, 0, sizeof(out));
+
+    const char* p = url;
+    if (strncmp(p, "http://", 7) == 0) {
+        p += 7;
+        out.port = 80;
+    } else if (strncmp(p, "https://", 8) == 0) {
+        p += 8;
+        out.port = 443;
+        out.tls = true;
+    } else {
+        return false;
+    }
+
+    const char* hostEnd = p;
+    while (*hostEnd && *hostEnd != ':' && *hostEnd != '/') hostEnd++;
+    size_t hostLen = hostEnd - p;
+    if (hostLen == 0 || hostLen >= HTTP_HOST_LEN) return false;
+    memcpy(out.host, p, hostLen);
+
+    p = hostEnd;
+    if (*p == ':') {
+        long port = strtol(p + 1, (char**)&p, 10);
+        if (port <= 0 || port > 65535) return false;
+        out.port = (uint16_t)port;
+    }
+
+    if (*p == '\0') {
+        strcpy(out.path, "/");
+    } else if (*p == '/' && strlen(p) < HTTP_PATH_LEN) {
+        strcpy(out.path, p);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int hexValue(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+long HttpChunkDecoder::feed(const uint8_t* buf, long len) {
+    long payload = 0;
+    long i = 0;
+    while (i < len && state != CHUNK_DONE && state != CHUNK_ERROR) {
+        uint8_t c = buf[i];
+        switch (state) {
+        case CHUNK_SIZE:
+            if (hexValue(c) >= 0) {
+                // Seven hex digits is already 256 MB; more is not a body we want
+                if (++digits > 7) state = CHUNK_ERROR;
+                remaining = remaining * 16 + hexValue(c);
+            } else if (c == ';' || c == ' ' || c == '\t') {
+                state = CHUNK_EXT;
+            } else if (c == '\n') {
+                if (digits == 0) state = CHUNK_ERROR;
+                else state = remaining > 0 ? CHUNK_DATA : CHUNK_DONE;
+            } else if (c != '\r') {
+                state = CHUNK_ERROR;
+            }
+            i++;
+            break;
+        case CHUNK_EXT:
+            if (c == '\n') {
+                if (digits == 0) state = CHUNK_ERROR;
+                else state = remaining > 0 ? CHUNK_DATA : CHUNK_DONE;
+            }
+            i++;
+            break;
+        case CHUNK_DATA: {
+            long n = len - i < remaining ? len - i : remaining;
+            payload += n;
+            remaining -= n;
+            i += n;
+            if (remaining == 0) state = CHUNK_DATA_END;
+            break;
+        }
+        case CHUNK_DATA_END:
+            // CRLF closing the chunk data, then the next size line
+            if (c == '\n') {
+                state = CHUNK_SIZE;
+                digits = 0;
+            } else if (c != '\r') {
+                state = CHUNK_ERROR;
+            }
+            i++;
+            break;
+        default:
+            break;
+        }
+    }
+    return payload;
+}
+
+HttpSession::HttpSession() : sock(-1), tls(nullptr) {}
+
+HttpSession::~HttpSession() {
+    closeSocket();
+}
+
+void HttpSession::closeSocket() {
+    endTls();
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+}
+
+bool HttpSession::waitFor(bool writable, int timeoutMs) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(sock, &set);
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    int rc = writable ? select(sock + 1, NULL, &set, NULL, &tv)
+                      : select(sock + 1, &set, NULL, NULL, &tv);
+    return rc > 0;
+}
+
+bool HttpSession::connectTo(uint32_t ip, uint16_t port, int timeoutMs) {
+    closeSocket();
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) return false;
+    if (!netSetNonBlocking(sock)) {
+        closeSocket();
+        return false;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = ip;
+
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) return true;
+    if (errno != EINPROGRESS || !waitFor(true, timeoutMs)) {
+        closeSocket();
+        return false;
+    }
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        closeSocket();
+        return false;
+    }
+    return true;
+}
+
+#ifdef ARDUINO
+bool HttpSession::startTls(const char* host, int timeoutMs) {
+    if (sock < 0) return false;
+    endTls();
+
+    tls = new TlsState;
+    tls->fd = sock;
+    mbedtls_ssl_init(&tls->ssl);
+    mbedtls_ssl_config_init(&tls->conf);
+    mbedtls_entropy_init(&tls->entropy);
+    mbedtls_ctr_drbg_init(&tls->drbg);
+
+    if (mbedtls_ctr_drbg_seed(&tls->drbg, mbedtls_entropy_func, &tls->entropy, NULL, 0) != 0 ||
+        mbedtls_ssl_config_defaults(&tls->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        endTls();
+        return false;
+    }
+    mbedtls_ssl_conf_authmode(&tls->conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&tls->conf, mbedtls_ctr_drbg_random, &tls->drbg);
+
+    if (mbedtls_ssl_setup(&tls->ssl, &tls->conf) != 0 ||
+        mbedtls_ssl_set_hostname(&tls->ssl, host) != 0) {
+        endTls();
+        return false;
+    }
+    mbedtls_ssl_set_bio(&tls->ssl, &tls->fd, tlsSend, tlsRecv, NULL);
+
+    for (;;) {
+        int rc = mbedtls_ssl_handshake(&tls->ssl);
+        if (rc == 0) return true;
+        bool ok = false;
+        if (rc == MBEDTLS_ERR_SSL_WANT_READ) ok = waitFor(false, timeoutMs);
+        else if (rc == MBEDTLS_ERR_SSL_WANT_WRITE) ok = waitFor(true, timeoutMs);
+        if (!ok) {
+            endTls();
+            return false;
+        }
+    }
+}
+
+void HttpSession::endTls() {
+    if (!tls) return;
+    mbedtls_ssl_free(&tls->ssl);
+    mbedtls_ssl_config_free(&tls->conf);
+    mbedtls_ctr_drbg_free(&tls->drbg);
+    mbedtls_entropy_free(&tls->entropy);
+    delete tls;
+    tls = nullptr;
+}
+#else
+// Host builds have no TLS stack; https probes report the handshake as failed
+bool HttpSession::startTls(const char*, int) {
+    return false;
+}
+
+void HttpSession::endTls() {}
+#endif
+
+bool HttpSession::sendAll(const void* data, size_t len, int timeoutMs) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+#ifdef ARDUINO
+        if (tls) {
+            int n = mbedtls_ssl_write(&tls->ssl, p, len);
+            if (n > 0) {
+                p += n;
+                len -= n;
+            } else if (n == MBEDTLS_ERR_SSL_WANT_WRITE || n == MBEDTLS_ERR_SSL_WANT_READ) {
+                if (!waitFor(n == MBEDTLS_ERR_SSL_WANT_WRITE, timeoutMs)) return false;
+            } else {
+                return false;
+            }
+            continue;
+        }
+#endif
+        int n = send(sock, p, len, 0);
+        if (n > 0) {
+            p += n;
+            len -= n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!waitFor(true, timeoutMs)) return false;
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+int HttpSession::recvSome(void* buf, size_t len, int timeoutMs) {
+#ifdef ARDUINO
+    while (tls) {
+        int n = mbedtls_ssl_read(&tls->ssl, (unsigned char*)buf, len);
+        if (n >= 0) return n;
+        if (n == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) return 0;
+        if (n != MBEDTLS_ERR_SSL_WANT_READ && n != MBEDTLS_ERR_SSL_WANT_WRITE) return -1;
+        if (!waitFor(n == MBEDTLS_ERR_SSL_WANT_WRITE, timeoutMs)) return -1;
+    }
+#endif
+    for (;;) {
+        int n = recv(sock, buf, len, 0);
+        if (n >= 0) return n;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+        if (!waitFor(false, timeoutMs)) return -1;
+    }
+}
+
+/**
+ * Reads until the end of the response head. Any body bytes that arrived
+ * in the same segments are left in buf after head.bodyOffset.
+ */
+bool HttpSession::readHead(uint8_t* buf, size_t size, int timeoutMs, HttpResponseHead& head,
+                           uint32_t* firstByteUs) {
+    head.status = -1;
+    head.contentLength = -1;
+    head.chunked = false;
+    head.bodyOffset = 0;
+    head.bufferedLen = 0;
+
+    size_t used = 0;
+    while (used < size - 1) {
+        int n = recvSome(buf + used, size - 1 - used, timeoutMs);
+        if (n <= 0) return false;
+        if (used == 0 && firstByteUs) *firstByteUs = netMicros();
+        used += n;
+        buf[used] = '\0';
+
+        char* end = strstr((char*)buf, "\r\n\r\n");
+        if (!end) continue;
+
+        *end = '\0';
+        head.bodyOffset = (end - (char*)buf) + 4;
+        head.bufferedLen = used;
+
+        char* line = strchr((char*)buf, ' ');
+        if (line) head.status = atoi(line + 1);
+
+        for (char* h = strstr((char*)buf, "\r\n"); h; h = strstr(h + 2, "\r\n")) {
+            if (strncasecmp(h + 2, "Content-Length:", 15) == 0) {
+                head.contentLength = atol(h + 17);
+            } else if (strncasecmp(h + 2, "Transfer-Encoding:", 18) == 0) {
+                const char* v = h + 20;
+                while (*v == ' ') v++;
+                head.chunked = strncasecmp(v, "chunked", 7) == 0;
+            }
+        }
+        return head.status > 0;
+    }
+    return false;
+}
@@ -0,0 +1,80 @@
+#ifndef HTTP_SESSION_H
+#define HTTP_SESSION_H
+
+#include "NetCompat.h"
+
+#define HTTP_HOST_LEN 64
+#define HTTP_PATH_LEN 128
+
+struct HttpUrl {
+    char host[HTTP_HOST_LEN];
+    uint16_t port;
+    char path[HTTP_PATH_LEN];
+    bool tls;
+};
+
+struct HttpResponseHead {
+    int status;
+    long contentLength;   // -1 when the server did not send one
+    bool chunked;         // Transfer-Encoding: chunked; contentLength is then -1
+    int bodyOffset;       // start of body bytes already in the buffer
+    int bufferedLen;      // bytes in the buffer after readHead()
+};
+
+// Parses http://host[:port]/path and https://... URLs
+bool parseHttpUrl(const char* url, HttpUrl& out);
+
+/**
+ * Incremental Transfer-Encoding: chunked decoder. feed() takes raw body
+ * bytes as they arrive and returns how many of them are payload, so chunk
+ * sizes, extensions and CRLFs are never counted. Trailers after the last
+ * chunk are not read; done() is set on the zero-size chunk.
+ */
+class HttpChunkDecoder {
+public:
+    HttpChunkDecoder() : state(CHUNK_SIZE), remaining(0), digits(0) {}
+    long feed(const uint8_t* buf, long len);
+    bool done() const { return state == CHUNK_DONE; }
+    bool failed() const { return state == CHUNK_ERROR; }
+
+private:
+    enum State { CHUNK_SIZE, CHUNK_EXT, CHUNK_DATA, CHUNK_DATA_END, CHUNK_DONE, CHUNK_ERROR };
+    State state;
+    long remaining;
+    int digits;
+};
+
+/**
+ * Thin blocking-with-timeout wrapper around a plain TCP socket. Used by the
+ * throughput and HTTP timing probes so they can move data in bulk and
+ * time each step themselves instead of going through WiFiClient.
+ * startTls() layers mbedTLS over the same socket (probe builds only);
+ * after that sendAll/recvSome go through the TLS record layer.
+ */
+class HttpSession {
+public:
+    HttpSession();
+    ~HttpSession();
+
+    bool connectTo(uint32_t ip, uint16_t port, int timeoutMs);
+    bool sendAll(const void* data, size_t len, int timeoutMs);
+    int recvSome(void* buf, size_t len, int timeoutMs);  // -1 error/timeout, 0 closed
+    // firstByteUs (optional) receives netMicros() when the first bytes arrive
+    bool readHead(uint8_t* buf, size_t size, int timeoutMs, HttpResponseHead& head,
+                  uint32_t* firstByteUs = nullptr);
+    // Handshake only: the certificate is not verified, this is for timing
+    bool startTls(const char* host, int timeoutMs);
+    bool secure() const { return tls != nullptr; }
+    void closeSocket();
+    int fd() const { return sock; }
+
+private:
+    struct TlsState;
+
+    bool waitFor(bool writable, int timeoutMs);
+    void endTls();
+    int sock;
+    TlsState* tls;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "HttpTimingProbe.h"
+#include <stdio.h>
+
+uint8_t HttpTimingProbe::buffer[HTTP_PROBE_BUFFER_SIZE];
+
+int HttpTimingProbe::elapsedMs(uint32_t fromUs, uint32_t toUs) {
+    return (int)((toUs - fromUs + 500) / 1000);
+}
+
+bool HttpTimingProbe::run(const char* urlText, const HttpProbeConfig& cfg, HttpTiming& out) {
+    out.status = -1;
+    out.failedPhase = HTTP_PHASE_URL;
+    out.dnsMs = out.connectMs = out.tlsMs = out.ttfbMs = out.transferMs = out.totalMs = -1;
+    out.bytes = 0;
+
+    HttpUrl url;
+    if (!parseHttpUrl(urlText, url)) return false;
+
+    uint32_t startUs = netMicros();
+    uint32_t ip;
+    out.failedPhase = HTTP_PHASE_DNS;
+    if (!netResolve(url.host, ip)) return false;
+    uint32_t t = netMicros();
+    out.dnsMs = elapsedMs(startUs, t);
+
+    HttpSession session;
+    out.failedPhase = HTTP_PHASE_CONNECT;
+    if (!session.connectTo(ip, url.port, cfg.timeoutMs)) return false;
+    uint32_t connectedUs = netMicros();
+    out.connectMs = elapsedMs(t, connectedUs);
+
+    if (url.tls) {
+        out.failedPhase = HTTP_PHASE_TLS;
+        if (!session.startTls(url.host, cfg.timeoutMs)) return false;
+        uint32_t securedUs = netMicros();
+        out.tlsMs = elapsedMs(connectedUs, securedUs);
+    }
+
+    char request[HTTP_PATH_LEN + HTTP_HOST_LEN + 64];
+    int len = snprintf(request, sizeof(request),
+                       "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                       url.path, url.host);
+    out.failedPhase = HTTP_PHASE_REQUEST;
+    if (!session.sendAll(request, len, cfg.timeoutMs)) return false;
+    uint32_t sentUs = netMicros();
+
+    HttpResponseHead head;
+    uint32_t firstByteUs = 0;
+    out.failedPhase = HTTP_PHASE_RESPONSE;
+    bool gotHead = session.readHead(buffer, sizeof(buffer), cfg.timeoutMs, head, &firstByteUs);
+    if (firstByteUs != 0) out.ttfbMs = elapsedMs(sentUs, firstByteUs);
+    if (!gotHead) return false;
+    out.status = head.status;
+
+    // Body: until Content-Length, close, or the byte cap
+    out.failedPhase = HTTP_PHASE_TRANSFER;
+    out.bytes = head.bufferedLen - head.bodyOffset;
+    bool complete = false;
+    for (;;) {
+        if (head.contentLength >= 0 && out.bytes >= head.contentLength) {
+            complete = true;
+            break;
+        }
+        if (out.bytes >= cfg.maxBytes) {
+            complete = true;
+            break;
+        }
+        int n = session.recvSome(buffer, sizeof(buffer), cfg.timeoutMs);
+        if (n == 0 && head.contentLength < 0) complete = true;
+        if (n <= 0) break;
+        out.bytes += n;
+    }
+    uint32_t endUs = netMicros();
+    out.transferMs = elapsedMs(firstByteUs, endUs);
+    out.totalMs = elapsedMs(startUs, endUs);
+
+    if (!complete) return false;
+    out.failedPhase = HTTP_PHASE_NONE;
+    return true;
+}
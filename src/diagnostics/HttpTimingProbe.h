@@ -0,0 +1,53 @@
+#ifndef HTTP_TIMING_PROBE_H
+#define HTTP_TIMING_PROBE_H
+
+#include "NetCompat.h"
+#include "HttpSession.h"
+
+#define HTTP_PROBE_BUFFER_SIZE 2048
+
+enum HttpPhase {
+    HTTP_PHASE_NONE,      // completed
+    HTTP_PHASE_URL,
+    HTTP_PHASE_DNS,
+    HTTP_PHASE_CONNECT,
+    HTTP_PHASE_TLS,
+    HTTP_PHASE_REQUEST,
+    HTTP_PHASE_RESPONSE,
+    HTTP_PHASE_TRANSFER
+};
+
+struct HttpProbeConfig {
+    int timeoutMs;        // per step
+    long maxBytes;        // stop reading the body after this many bytes
+};
+
+// Every duration is -1 when the phase was not reached
+struct HttpTiming {
+    int status;           // HTTP status, -1 if no response
+    uint8_t failedPhase;  // HttpPhase, HTTP_PHASE_NONE on success
+    int dnsMs;
+    int connectMs;
+    int tlsMs;            // -1 for plain http
+    int ttfbMs;           // request sent to first response byte
+    int transferMs;       // first byte to end of body
+    int totalMs;
+    long bytes;           // body bytes read
+};
+
+/**
+ * One HTTP(S) GET with every step timed on its own: name lookup, TCP
+ * connect, TLS handshake, time to first byte and body transfer. Built on
+ * HttpSession, so it runs against a local HTTP stand-in on a host build.
+ * Not re-entrant: the response buffer is shared.
+ */
+class HttpTimingProbe {
+public:
+    static bool run(const char* url, const HttpProbeConfig& cfg, HttpTiming& out);
+
+private:
+    static int elapsedMs(uint32_t fromUs, uint32_t toUs);
+    static uint8_t buffer[HTTP_PROBE_BUFFER_SIZE];
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "IcmpEngine.h"
+
+static uint16_t nextIdentifier() {
+    static uint16_t counter = 0;
+    return (uint16_t)((netRandom() & 0xFF00) | (++counter & 0x00FF));
+}
+
+int IcmpEngine::openSocket() {
+    return openIcmpSocket(NET_ICMP_ECHO_SOCK_TYPE);
+}
+
+int IcmpEngine::openRawSocket() {
+    return openIcmpSocket(SOCK_RAW);
+}
+
+int IcmpEngine::openIcmpSocket(int type) {
+    int sock = socket(AF_INET, type, IPPROTO_ICMP);
+    if (sock < 0) return -1;
+    if (!netSetNonBlocking(sock)) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+bool IcmpEngine::sendEcho(int sock, uint32_t ip, uint16_t id, uint16_t seq) {
+    uint8_t packet[sizeof(IcmpEchoHeader) + ICMP_PAYLOAD_SIZE];
+    IcmpEchoHeader* hdr = (IcmpEchoHeader*)packet;
+
+    hdr->type = ICMP_TYPE_ECHO_REQUEST;
+    hdr->code = 0;
+    hdr->checksum = 0;
+    hdr->id = htons(id);
+    hdr->seq = htons(seq);
+    for (int i = 0; i < ICMP_PAYLOAD_SIZE; i++) {
+        packet[sizeof(IcmpEchoHeader) + i] = (uint8_t)('a' + i % 26);
+    }
+    hdr->checksum = netChecksum(packet, sizeof(packet));
+
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = ip;
+
+    int sent = sendto(sock, packet, sizeof(packet), 0, (struct sockaddr*)&to, sizeof(to));
+    return sent == (int)sizeof(packet);
+}
+
+/**
+ * Raw IPv4 sockets deliver the IP header in front of the ICMP message; a
+ * ping socket delivers the bare message, with the identifier rewritten by
+ * the kernel, which only queues a socket its own replies.
+ * Returns the echo sequence number, or -1 if this is not one of our replies.
+ */
+int IcmpEngine::parseEchoReply(const uint8_t* buf, int len, uint16_t id) {
+#if NET_ICMP_ECHO_IP_HEADER
+    if (len < 20) return -1;
+    int ipHeaderLen = (buf[0] & 0x0F) * 4;
+#else
+    int ipHeaderLen = 0;
+#endif
+    if (len < ipHeaderLen + (int)sizeof(IcmpEchoHeader)) return -1;
+
+    const IcmpEchoHeader* hdr = (const IcmpEchoHeader*)(buf + ipHeaderLen);
+    if (hdr->type != ICMP_TYPE_ECHO_REPLY) return -1;
+#if NET_ICMP_ECHO_IP_HEADER
+    if (ntohs(hdr->id) != id) return -1;
+#else
+    (void)id;
+#endif
+    return ntohs(hdr->seq);
+}
+
+bool IcmpEngine::ping(uint32_t ip, const IcmpConfig& cfg, LatencyStats& out, float* rttMs) {
+    return pingMany(&ip, 1, cfg, &out, rttMs) == 1;
+}
+
+/**
+ * Every target gets its own socket and identifier; each pacing slot sends
+ * one request to every target, and select() waits on all sockets at once.
+ * rttMs (optional) is laid out as targetCount rows of ICMP_MAX_PACKETS.
+ * Returns the number of targets whose socket could be opened.
+ */
+int IcmpEngine::pingMany(const uint32_t* ips, int targetCount, const IcmpConfig& cfg, LatencyStats* out, float* rttMs) {
+    int count = cfg.count;
+    if (count < 1) count = 1;
+    if (count > ICMP_MAX_PACKETS) count = ICMP_MAX_PACKETS;
+    if (targetCount > ICMP_MAX_TARGETS) targetCount = ICMP_MAX_TARGETS;
+
+    int socks[ICMP_MAX_TARGETS];
+    uint16_t ids[ICMP_MAX_TARGETS];
+    float rtts[ICMP_MAX_TARGETS][ICMP_MAX_PACKETS];
+    uint32_t sentAt[ICMP_MAX_TARGETS][ICMP_MAX_PACKETS];
+    int received = 0;
+    int opened = 0;
+    int maxFd = -1;
+
+    for (int t = 0; t < targetCount; t++) {
+        for (int i = 0; i < count; i++) rtts[t][i] = -1;
+        socks[t] = openSocket();
+        ids[t] = nextIdentifier();
+        if (socks[t] < 0) continue;
+        opened++;
+        if (socks[t] > maxFd) maxFd = socks[t];
+    }
+
+    uint32_t start = netMicros();
+    uint32_t intervalUs = (uint32_t)cfg.intervalMs * 1000;
+    uint32_t deadlineUs = (uint32_t)(count - 1) * intervalUs + (uint32_t)cfg.timeoutMs * 1000;
+    int nextSeq = 0;
+
+    while (opened > 0 && received < opened * count) {
+        uint32_t elapsed = netMicros() - start;
+        if (elapsed >= deadlineUs) break;
+
+        if (nextSeq < count && elapsed >= (uint32_t)nextSeq * intervalUs) {
+            for (int t = 0; t < targetCount; t++) {
+                if (socks[t] < 0) continue;
+                sentAt[t][nextSeq] = netMicros();
+                sendEcho(socks[t], ips[t], ids[t], (uint16_t)nextSeq);
+            }
+            nextSeq++;
+            continue;
+        }
+
+        // Sleep until the next send slot or the deadline, whichever comes first
+        uint32_t waitUs = deadlineUs - elapsed;
+        if (nextSeq < count) {
+            uint32_t untilSend = (uint32_t)nextSeq * intervalUs - elapsed;
+            if (untilSend < waitUs) waitUs = untilSend;
+        }
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        for (int t = 0; t < targetCount; t++) {
+            if (socks[t] >= 0) FD_SET(socks[t], &readSet);
+        }
+        struct timeval tv;
+        tv.tv_sec = waitUs / 1000000;
+        tv.tv_usec = waitUs % 1000000;
+        if (select(maxFd + 1, &readSet, NULL, NULL, &tv) <= 0) continue;
+
+        for (int t = 0; t < targetCount; t++) {
+            if (socks[t] < 0 || !FD_ISSET(socks[t], &readSet)) continue;
+
+            uint8_t buf[128];
+            struct sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            int len;
+            while ((len = recvfrom(socks[t], buf, sizeof(buf), 0,
+                                   (struct sockaddr*)&from, &fromLen)) > 0) {
+                uint32_t now = netMicros();
+                fromLen = sizeof(from);
+                int seq = parseEchoReply(buf, len, ids[t]);
+                if (seq < 0 || seq >= nextSeq || from.sin_addr.s_addr != ips[t]) continue;
+                if (rtts[t][seq] >= 0) continue; // duplicate
+                rtts[t][seq] = (now - sentAt[t][seq]) / 1000.0f;
+                received++;
+            }
+        }
+    }
+
+    for (int t = 0; t < targetCount; t++) {
+        if (socks[t] >= 0) close(socks[t]);
+        out[t] = computeLatencyStats(rtts[t], count);
+        if (rttMs) memcpy(rttMs + t * ICMP_MAX_PACKETS, rtts[t], count * sizeof(float));
+    }
+    return opened;
+}
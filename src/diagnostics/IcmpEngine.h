@@ -0,0 +1,51 @@
+#ifndef ICMP_ENGINE_H
+#define ICMP_ENGINE_H
+
+#include "NetCompat.h"
+#include "LatencyStats.h"
+
+#define ICMP_MAX_PACKETS 32
+#define ICMP_MAX_TARGETS 7   // MAX_PROBE_TARGETS plus the implicit gateway
+#define ICMP_PAYLOAD_SIZE 32
+#define ICMP_TYPE_ECHO_REPLY 0
+#define ICMP_TYPE_ECHO_REQUEST 8
+
+struct IcmpConfig {
+    int count;       // echo requests to send (capped at ICMP_MAX_PACKETS)
+    int intervalMs;  // pacing between requests
+    int timeoutMs;   // wait for the last reply
+};
+
+struct IcmpEchoHeader {
+    uint8_t type;
+    uint8_t code;
+    uint16_t checksum;
+    uint16_t id;
+    uint16_t seq;
+} __attribute__((packed));
+
+/**
+ * ICMP echo engine. Sends paced echo requests and matches
+ * replies by identifier/sequence so every packet gets its own RTT.
+ * Several targets are probed at once, one non-blocking socket each,
+ * multiplexed with select(), so a cycle lasts as long as the slowest target.
+ */
+class IcmpEngine {
+public:
+    // ip is in network byte order; rttMs (optional) receives per-packet RTTs
+    static bool ping(uint32_t ip, const IcmpConfig& cfg, LatencyStats& out, float* rttMs = nullptr);
+    static int pingMany(const uint32_t* ips, int targetCount, const IcmpConfig& cfg,
+                        LatencyStats* out, float* rttMs = nullptr);
+
+private:
+    friend class PathProbe;   // shares the socket and echo helpers
+    // Echo-only socket: raw on the probe, a ping socket on a host build
+    static int openSocket();
+    // Always raw; Time Exceeded and Unreachable only reach raw sockets
+    static int openRawSocket();
+    static int openIcmpSocket(int type);
+    static bool sendEcho(int sock, uint32_t ip, uint16_t id, uint16_t seq);
+    static int parseEchoReply(const uint8_t* buf, int len, uint16_t id);
+};
+
+#endif
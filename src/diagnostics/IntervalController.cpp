@@ -0,0 +1,58 @@
+#include "IntervalController.h"
+
+bool IntervalController::enabled = false;
+int IntervalController::minSeconds = 60;
+int IntervalController::maxSeconds = 60;
+int IntervalController::current = 60;
+int IntervalController::stableRun = 0;
+IntervalReason IntervalController::why = IVL_FIXED;
+
+void IntervalController::configure(bool adaptive, int fixedS, int minS, int maxS) {
+    enabled = adaptive;
+    stableRun = 0;
+    if (!enabled) {
+        minSeconds = maxSeconds = current = fixedS;
+        why = IVL_FIXED;
+        return;
+    }
+    minSeconds = minS;
+    maxSeconds = maxS < minS ? minS : maxS;
+    current = minSeconds;
+    why = IVL_LEARNING;
+}
+
+void IntervalController::update(bool stable) {
+    if (!enabled) return;
+
+    if (!stable) {
+        // Still learning until the first stable cycle has been seen
+        if (why != IVL_LEARNING) why = IVL_CHANGE;
+        current = minSeconds;
+        stableRun = 0;
+        return;
+    }
+
+    stableRun++;
+    if (stableRun < INTERVAL_STABLE_CYCLES) return;
+
+    int next = (int)(current * INTERVAL_GROWTH);
+    current = next > maxSeconds ? maxSeconds : next;
+    why = IVL_STABLE;
+}
+
+void IntervalController::snapBack() {
+    if (!enabled) return;
+    current = minSeconds;
+    stableRun = 0;
+    why = IVL_CHANGE;
+}
+
+const char* IntervalController::reasonName(IntervalReason r) {
+    switch (r) {
+    case IVL_FIXED: return "fixed";
+    case IVL_LEARNING: return "learning";
+    case IVL_STABLE: return "stable";
+    case IVL_CHANGE: return "change";
+    default: return "unknown";
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef INTERVAL_CONTROLLER_H
+#define INTERVAL_CONTROLLER_H
+
+#include <stdint.h>
+
+#define INTERVAL_GROWTH 1.5f        // stretch per stable cycle
+#define INTERVAL_STABLE_CYCLES 2    // stable cycles needed before stretching
+
+enum IntervalReason {
+    IVL_FIXED,      // adaptive mode off, reportInterval applies
+    IVL_LEARNING,   // baselines not settled yet, fast cadence
+    IVL_STABLE,     // readings inside the band, interval stretched
+    IVL_CHANGE      // a reading left the band, back to the fast cadence
+};
+
+/**
+ * Report interval control loop. Every completed cycle says whether its
+ * readings stayed inside the detectors' variance band; after a few stable
+ * cycles the interval grows geometrically up to maxS, and any reading
+ * outside the band (or a change event between cycles) snaps it back to minS.
+ */
+class IntervalController {
+public:
+    static void configure(bool adaptive, int fixedS, int minS, int maxS);
+    static void update(bool stable);
+    static void snapBack();
+
+    static int seconds() { return current; }
+    static IntervalReason reason() { return why; }
+    static const char* reasonName(IntervalReason r);
+
+private:
+    static bool enabled;
+    static int minSeconds;
+    static int maxSeconds;
+    static int current;
+    static int stableRun;
+    static IntervalReason why;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "LatencyStats.h"
+#include <algorithm>
+#include <math.h>
+
+#define LATENCY_STATS_MAX_SAMPLES 64
+
+float percentileSorted(const float* sorted, int count, float pct) {
+    if (count <= 0) return -1;
+    int rank = (int)ceilf(pct / 100.0f * count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+LatencyStats computeLatencyStats(const float* rttMs, int count) {
+    LatencyStats s;
+    s.sent = count;
+    s.received = 0;
+    s.minMs = s.avgMs = s.maxMs = s.p50Ms = s.p95Ms = s.jitterMs = -1;
+
+    float sorted[LATENCY_STATS_MAX_SAMPLES];
+    float sum = 0;
+    float jitter = 0;
+    float prev = -1;
+
+    for (int i = 0; i < count && i < LATENCY_STATS_MAX_SAMPLES; i++) {
+        float rtt = rttMs[i];
+        if (rtt < 0) continue;
+
+        sorted[s.received++] = rtt;
+        sum += rtt;
+
+        // RFC 3550 6.4.1: J += (|D(i-1,i)| - J) / 16, with equal send spacing
+        // the transit-time difference reduces to the RTT difference
+        if (prev >= 0) {
+            jitter += (fabsf(rtt - prev) - jitter) / 16.0f;
+        }
+        prev = rtt;
+    }
+
+    s.lossPct = count > 0 ? 100.0f * (count - s.received) / count : 100.0f;
+    if (s.received == 0) return s;
+
+    std::sort(sorted, sorted + s.received);
+    s.minMs = sorted[0];
+    s.maxMs = sorted[s.received - 1];
+    s.avgMs = sum / s.received;
+    s.p50Ms = percentileSorted(sorted, s.received, 50);
+    s.p95Ms = percentileSorted(sorted, s.received, 95);
+    s.jitterMs = jitter;
+    return s;
+}
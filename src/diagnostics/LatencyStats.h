@@ -0,0 +1,28 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+struct LatencyStats {
+    int sent;
+    int received;
+    float lossPct;   // 0-100, fractional
+    float minMs;
+    float avgMs;
+    float maxMs;
+    float p50Ms;
+    float p95Ms;
+    float jitterMs;  // RFC 3550 interarrival jitter estimate
+};
+
+/**
+ * Summarises per-packet round-trip times. rttMs holds one entry per packet
+ * in send order; negative entries are packets that were never answered.
+ * Every statistic except loss is -1 when nothing came back.
+ */
+LatencyStats computeLatencyStats(const float* rttMs, int count);
+
+// Nearest-rank percentile over an already sorted sample array
+float percentileSorted(const float* sorted, int count, float pct);
+
+#endif
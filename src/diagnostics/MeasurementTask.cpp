@@ -0,0 +1,220 @@
+#include "MeasurementTask.h"
+#include "IcmpEngine.h"
+
+SystemConfig* MeasurementTask::activeConfig = nullptr;
+QueueHandle_t MeasurementTask::resultQueue = NULL;
+SemaphoreHandle_t MeasurementTask::radioMutex = NULL;
+volatile MeasurementPhase MeasurementTask::phase = PHASE_IDLE;
+volatile bool MeasurementTask::cycleRequested = false;
+unsigned long MeasurementTask::lastCycleStart = 0;
+unsigned long MeasurementTask::lastFastSample = 0;
+MetricSummary MeasurementTask::rssiSummary;
+MetricSummary MeasurementTask::gwRttSummary;
+int MeasurementTask::gwProbesSent = 0;
+int MeasurementTask::gwProbesLost = 0;
+
+void MeasurementTask::begin(SystemConfig* config) {
+    if (resultQueue != NULL) return;
+
+    activeConfig = config;
+    lastCycleStart = millis();
+    // Adaptive mode leans on the change detectors' baselines
+    IntervalController::configure(config->adaptiveInterval && config->eventDetect,
+                                  config->reportInterval,
+                                  config->intervalMinS > 0 ? config->intervalMinS : config->reportInterval,
+                                  config->intervalMaxS);
+
+    DiagnosticEngine::registerModules();
+
+    resultQueue = xQueueCreate(MEASUREMENT_QUEUE_DEPTH, sizeof(NetworkMetrics));
+    radioMutex = xSemaphoreCreateMutex();
+    DiagnosticEngine::beginEvents();
+
+    // A config change reboots, so the URL list seen here is the one probed
+    uint32_t stack = strstr(config->httpUrls, "https://") != NULL ? MEASUREMENT_STACK_TLS : MEASUREMENT_STACK;
+    xTaskCreatePinnedToCore(
+        measurementTask,
+        "measureTask",
+        stack,
+        NULL,
+        1,
+        NULL,
+        0
+    );
+
+    Serial.println("[MEASURE] Measurement task started on Core 0");
+}
+
+/**
+ * One phase per pass, yielding in between so a long cycle is spread out
+ * and the radio lock can be handed over as soon as the cycle completes.
+ */
+void MeasurementTask::measurementTask(void* pvParameters) {
+    NetworkMetrics m = {};
+
+    for(;;) {
+        switch (phase) {
+            case PHASE_IDLE:
+                if (!cycleDue()) {
+                    sampleFast();
+                    vTaskDelay(200 / portTICK_PERIOD_MS);
+                    continue;
+                }
+                if (!acquireRadio(1000)) continue;
+
+                lastCycleStart = millis();
+                cycleRequested = false;
+                memset(&m, 0, sizeof(m));
+                takeSamples(m);
+                Serial.println("\n[MEASURE] Telemetry Cycle");
+                phase = PHASE_PLAN;
+                break;
+
+            case PHASE_PLAN:
+                if (WiFi.status() != WL_CONNECTED) {
+                    Serial.println("[MEASURE] WiFi not connected, cycle skipped");
+                    releaseRadio();
+                    phase = PHASE_IDLE;
+                    break;
+                }
+                CycleScheduler::plan(*activeConfig, activeConfig->cycleBudgetMs);
+                phase = PHASE_PROBES;
+                break;
+
+            case PHASE_PROBES:
+                // One module, or one poll of an asynchronous one, per pass
+                switch (CycleScheduler::step(m, *activeConfig)) {
+                    case SCHED_WAIT:
+                        vTaskDelay(20 / portTICK_PERIOD_MS);
+                        continue;
+                    case SCHED_BUSY:
+                        break;
+                    case SCHED_DONE:
+                        m.deferredMask = CycleScheduler::deferredMask();
+                        phase = PHASE_DELIVER;
+                        break;
+                }
+                break;
+
+            case PHASE_DELIVER: {
+                // Judge stability against the baseline before this cycle is folded into it
+                bool stable = DiagnosticEngine::isStable(m);
+                DiagnosticEngine::detectChanges(m, *activeConfig);
+                IntervalController::update(stable);
+                m.intervalS = IntervalController::seconds();
+                m.intervalReason = IntervalController::reason();
+                m.cycleMs = millis() - lastCycleStart;
+                deliver(m);
+                Serial.printf("[MEASURE] Cycle completed in %d ms\n", m.cycleMs);
+                releaseRadio();
+                phase = PHASE_IDLE;
+                break;
+            }
+        }
+
+        vTaskDelay(1);
+    }
+}
+
+bool MeasurementTask::cycleDue() {
+    if (cycleRequested) return true;
+    if (!activeConfig) return false;
+
+    unsigned long interval = IntervalController::seconds() * 1000UL;
+    return millis() - lastCycleStart > interval;
+}
+
+/**
+ * Cheap between-cycle sampling: one RSSI read and one gateway echo every
+ * sampleIntervalMs. Skipped whenever someone else holds the radio (deep
+ * scan, throughput test) rather than waiting for it.
+ */
+void MeasurementTask::sampleFast() {
+    if (!activeConfig) return;
+    if (millis() - lastFastSample < (unsigned long)activeConfig->sampleIntervalMs) return;
+    lastFastSample = millis();
+
+    if (WiFi.status() != WL_CONNECTED) return;
+    if (!acquireRadio(0)) return;
+
+    int rssi = WiFi.RSSI();
+    rssiSummary.add(rssi);
+    // A drop seen between cycles pulls the next full report forward
+    if (DiagnosticEngine::observe(CHANGE_RSSI, rssi, *activeConfig)) {
+        IntervalController::snapBack();
+        requestCycle();
+    }
+
+    uint32_t gw = (uint32_t)WiFi.gatewayIP();
+    if (gw != 0) {
+        IcmpConfig cfg = {1, 0, 500};
+        LatencyStats stats;
+        float rtt;
+        if (IcmpEngine::ping(gw, cfg, stats, &rtt)) {
+            gwProbesSent++;
+            if (rtt >= 0) {
+                gwRttSummary.add(rtt);
+            } else {
+                gwProbesLost++;
+            }
+        }
+    }
+
+    releaseRadio();
+}
+
+// Moves the interval's summaries into the cycle's metrics and starts afresh
+void MeasurementTask::takeSamples(NetworkMetrics& m) {
+    rssiSummary.snapshot(m.rssiSamples);
+    gwRttSummary.snapshot(m.gwRttSamples);
+    m.gwProbesSent = gwProbesSent;
+    m.gwProbesLost = gwProbesLost;
+
+    rssiSummary.reset();
+    gwRttSummary.reset();
+    gwProbesSent = 0;
+    gwProbesLost = 0;
+}
+
+void MeasurementTask::deliver(const NetworkMetrics& m) {
+    // Keep the newest sample if the publisher has fallen behind
+    if (xQueueSend(resultQueue, &m, 0) != pdTRUE) {
+        NetworkMetrics stale;
+        xQueueReceive(resultQueue, &stale, 0);
+        xQueueSend(resultQueue, &m, 0);
+        Serial.println("[MEASURE] ⚠ Result queue full, dropped oldest sample");
+    }
+}
+
+bool MeasurementTask::nextResult(NetworkMetrics& out) {
+    if (resultQueue == NULL) return false;
+    return xQueueReceive(resultQueue, &out, 0) == pdTRUE;
+}
+
+void MeasurementTask::requestCycle() {
+    cycleRequested = true;
+}
+
+MeasurementPhase MeasurementTask::getPhase() {
+    return phase;
+}
+
+bool MeasurementTask::acquireRadio(uint32_t timeoutMs) {
+    if (radioMutex == NULL) return true;
+    return xSemaphoreTake(radioMutex, timeoutMs / portTICK_PERIOD_MS) == pdTRUE;
+}
+
+bool MeasurementTask::acquireRadio(uint32_t timeoutMs, void (*idle)()) {
+    unsigned long start = millis();
+    for (;;) {
+        unsigned long waited = millis() - start;
+        if (waited >= timeoutMs) return false;
+        if (acquireRadio(min((unsigned long)RADIO_WAIT_SLICE_MS, timeoutMs - waited))) return true;
+        idle();
+    }
+}
+
+void MeasurementTask::releaseRadio() {
+    if (radioMutex == NULL) return;
+    xSemaphoreGive(radioMutex);
+}
@@ -0,0 +1,67 @@
+#ifndef MEASUREMENT_TASK_H
+#define MEASUREMENT_TASK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "DiagnosticEngine.h"
+#include "IntervalController.h"
+#include "CycleScheduler.h"
+#include "../storage/ConfigManager.h"
+
+#define MEASUREMENT_QUEUE_DEPTH 2
+#define RADIO_COMMAND_WAIT_MS 30000     // how long a command waits out a cycle for the radio
+#define RADIO_WAIT_SLICE_MS 100
+#define MEASUREMENT_STACK 8192
+#define MEASUREMENT_STACK_TLS 16384     // mbedTLS handshakes for https HTTP probes run on this stack
+
+enum MeasurementPhase {
+    PHASE_IDLE,
+    PHASE_PLAN,
+    PHASE_PROBES,
+    PHASE_DELIVER
+};
+
+/**
+ * Runs the telemetry measurement cycle in its own FreeRTOS task so the
+ * MQTT/command path in loop() never waits on a scan, ping or DNS lookup.
+ * What a cycle measures is up to the CycleScheduler and its budget.
+ * Finished NetworkMetrics are handed to the publisher through a queue.
+ */
+class MeasurementTask {
+public:
+    static void begin(SystemConfig* config);
+    static void measurementTask(void* pvParameters);
+
+    // Publisher side: non-blocking, returns false when nothing is ready
+    static bool nextResult(NetworkMetrics& out);
+    static void requestCycle();
+    static MeasurementPhase getPhase();
+
+    // Exclusive use of the radio for callers that scan/sniff (deep scans)
+    static bool acquireRadio(uint32_t timeoutMs);
+    // Same, in short slices with idle() run in between; for waits in loop()
+    static bool acquireRadio(uint32_t timeoutMs, void (*idle)());
+    static void releaseRadio();
+
+private:
+    static bool cycleDue();
+    static void sampleFast();
+    static void takeSamples(NetworkMetrics& m);
+    static void deliver(const NetworkMetrics& m);
+
+    static SystemConfig* activeConfig;
+    static QueueHandle_t resultQueue;
+    static SemaphoreHandle_t radioMutex;
+    static volatile MeasurementPhase phase;
+    static volatile bool cycleRequested;
+    static unsigned long lastCycleStart;
+    static unsigned long lastFastSample;
+    static MetricSummary rssiSummary;
+    static MetricSummary gwRttSummary;
+    static int gwProbesSent;
+    static int gwProbesLost;
+};
+
+#endif
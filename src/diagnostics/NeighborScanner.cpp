@@ -0,0 +1,111 @@
+#include "NeighborScanner.h"
+
+NeighborEntry NeighborScanner::table[NEIGHBOR_TABLE_SIZE];
+uint8_t NeighborScanner::nextChannel = 1;
+uint8_t NeighborScanner::channelsThisStep = 0;
+bool NeighborScanner::scanInFlight = false;
+unsigned long NeighborScanner::scanStartedAt = 0;
+unsigned long NeighborScanner::sweepStartedAt = 0;
+unsigned long NeighborScanner::prevSweepStartedAt = 0;
+
+bool NeighborScanner::step() {
+    if (scanInFlight) {
+        int16_t result = WiFi.scanComplete();
+
+        if (result == WIFI_SCAN_RUNNING) {
+            if (millis() - scanStartedAt < NEIGHBOR_SCAN_TIMEOUT_MS) return false;
+            Serial.println("[SCAN] Channel scan timed out");
+            result = WIFI_SCAN_FAILED;
+        }
+
+        if (result >= 0) {
+            collect(result);
+        }
+        WiFi.scanDelete();
+        scanInFlight = false;
+        channelsThisStep++;
+    }
+
+    if (channelsThisStep >= NEIGHBOR_CHANNELS_PER_STEP) {
+        channelsThisStep = 0;
+        return true;
+    }
+
+    startChannel(nextChannel);
+    nextChannel++;
+    if (nextChannel > NEIGHBOR_MAX_CHANNEL) {
+        nextChannel = 1;
+        prevSweepStartedAt = sweepStartedAt;
+        sweepStartedAt = millis();
+    }
+    return false;
+}
+
+void NeighborScanner::startChannel(uint8_t channel) {
+    scanStartedAt = millis();
+    int16_t rc = WiFi.scanNetworks(true, false, false, NEIGHBOR_DWELL_MS, channel);
+    // A failed start is treated like an empty channel so the rotation keeps moving
+    scanInFlight = true;
+    if (rc == WIFI_SCAN_FAILED) {
+        Serial.printf("[SCAN] Failed to start scan on channel %d\n", channel);
+    }
+}
+
+void NeighborScanner::collect(int found) {
+    unsigned long now = millis();
+    for (int i = 0; i < found; i++) {
+        uint8_t* bssid = WiFi.BSSID(i);
+        if (!bssid) continue;
+        upsert(bssid, WiFi.channel(i), WiFi.RSSI(i), now);
+    }
+}
+
+void NeighborScanner::upsert(const uint8_t* bssid, uint8_t channel, int8_t rssi, unsigned long now) {
+    int freeSlot = -1;
+    int oldestSlot = 0;
+
+    for (int i = 0; i < NEIGHBOR_TABLE_SIZE; i++) {
+        NeighborEntry& e = table[i];
+        if (e.used && memcmp(e.bssid, bssid, 6) == 0) {
+            e.channel = channel;
+            e.rssi = rssi;
+            e.lastSeen = now;
+            return;
+        }
+        if (!e.used || !isFresh(e)) {
+            if (freeSlot < 0) freeSlot = i;
+        } else if (e.lastSeen < table[oldestSlot].lastSeen) {
+            oldestSlot = i;
+        }
+    }
+
+    // Table full of live entries: evict the least recently seen one
+    NeighborEntry& slot = table[freeSlot >= 0 ? freeSlot : oldestSlot];
+    memcpy(slot.bssid, bssid, 6);
+    slot.channel = channel;
+    slot.rssi = rssi;
+    slot.lastSeen = now;
+    slot.used = true;
+}
+
+bool NeighborScanner::isFresh(const NeighborEntry& e) {
+    // Until two sweeps have completed everything collected so far counts
+    if (prevSweepStartedAt == 0) return true;
+    return e.lastSeen >= prevSweepStartedAt;
+}
+
+int NeighborScanner::neighborCount() {
+    int count = 0;
+    for (int i = 0; i < NEIGHBOR_TABLE_SIZE; i++) {
+        if (table[i].used && isFresh(table[i])) count++;
+    }
+    return count;
+}
+
+int NeighborScanner::overlappingCount(int channel) {
+    int count = 0;
+    for (int i = 0; i < NEIGHBOR_TABLE_SIZE; i++) {
+        if (table[i].used && isFresh(table[i]) && table[i].channel == channel) count++;
+    }
+    return count;
+}
@@ -0,0 +1,49 @@
+#ifndef NEIGHBOR_SCANNER_H
+#define NEIGHBOR_SCANNER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define NEIGHBOR_TABLE_SIZE 48
+#define NEIGHBOR_MAX_CHANNEL 13
+#define NEIGHBOR_CHANNELS_PER_STEP 3
+#define NEIGHBOR_DWELL_MS 120
+#define NEIGHBOR_SCAN_TIMEOUT_MS 2000
+
+struct NeighborEntry {
+    uint8_t bssid[6];
+    uint8_t channel;
+    int8_t rssi;
+    unsigned long lastSeen;
+    bool used;
+};
+
+/**
+ * Rolling neighbor scan: each step scans a few channels asynchronously and
+ * merges the results into a fixed-capacity table keyed by BSSID. Entries not
+ * seen during the last complete sweep of all channels are aged out.
+ */
+class NeighborScanner {
+public:
+    // Advance the current step; returns true once its channel subset is done
+    static bool step();
+
+    static int neighborCount();
+    static int overlappingCount(int channel);
+
+private:
+    static void startChannel(uint8_t channel);
+    static void collect(int found);
+    static void upsert(const uint8_t* bssid, uint8_t channel, int8_t rssi, unsigned long now);
+    static bool isFresh(const NeighborEntry& e);
+
+    static NeighborEntry table[NEIGHBOR_TABLE_SIZE];
+    static uint8_t nextChannel;
+    static uint8_t channelsThisStep;
+    static bool scanInFlight;
+    static unsigned long scanStartedAt;
+    static unsigned long sweepStartedAt;
+    static unsigned long prevSweepStartedAt;
+};
+
+#endif
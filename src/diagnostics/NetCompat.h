@@ -0,0 +1,91 @@
+#ifndef NET_COMPAT_H
+#define NET_COMPAT_H
+
+/**
+ * Socket and clock shims shared by the raw-socket measurement engines.
+ * On the probe these map to lwIP's BSD socket layer; on a host build they
+ * map to POSIX so the engines can be exercised against local stand-ins.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <lwip/sockets.h>
+#include <lwip/inet.h>
+#include <lwip/netdb.h>
+#include <esp_random.h>
+
+inline uint32_t netMicros() { return (uint32_t)micros(); }
+inline uint32_t netRandom() { return esp_random(); }
+inline void netSleepMs(uint32_t ms) { vTaskDelay(ms / portTICK_PERIOD_MS); }
+
+// lwIP hands raw sockets to anyone, IP header included
+#define NET_ICMP_ECHO_SOCK_TYPE SOCK_RAW
+#define NET_ICMP_ECHO_IP_HEADER 1
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+
+inline uint32_t netMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+inline uint32_t netRandom() { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+inline void netSleepMs(uint32_t ms) { usleep(ms * 1000); }
+
+// Unprivileged ping socket (net.ipv4.ping_group_range): no CAP_NET_RAW, no
+// IP header on receive, and the kernel owns the echo identifier
+#define NET_ICMP_ECHO_SOCK_TYPE SOCK_DGRAM
+#define NET_ICMP_ECHO_IP_HEADER 0
+#endif
+
+inline bool netSetNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return false;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Dotted quad or name lookup through the stack's resolver; ip in network byte order
+inline bool netResolve(const char* host, uint32_t& ip) {
+    struct in_addr literal;
+    if (inet_aton(host, &literal)) {
+        ip = literal.s_addr;
+        return true;
+    }
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = NULL;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0 || res == NULL) return false;
+    ip = ((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(res);
+    return true;
+}
+
+// Internet checksum (RFC 1071) over an arbitrary buffer
+inline uint16_t netChecksum(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t sum = 0;
+    while (len > 1) {
+        sum += (uint16_t)((p[0] << 8) | p[1]);
+        p += 2;
+        len -= 2;
+    }
+    if (len) sum += (uint16_t)(p[0] << 8);
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return htons((uint16_t)~sum);
+}
+
+#endif
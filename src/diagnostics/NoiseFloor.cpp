@@ -0,0 +1,53 @@
+#include "NoiseFloor.h"
+#include <string.h>
+
+int8_t NoiseFloorEstimator::window[NOISE_WINDOW];
+int NoiseFloorEstimator::next = 0;
+int NoiseFloorEstimator::filled = 0;
+
+void NoiseHistogram::reset() {
+    memset(bins, 0, sizeof(bins));
+    total = 0;
+}
+
+void NoiseHistogram::add(int8_t dbm) {
+    int bin = dbm - NOISE_HIST_MIN_DBM;
+    if (bin < 0) bin = 0;
+    if (bin >= NOISE_HIST_BINS) bin = NOISE_HIST_BINS - 1;
+    if (bins[bin] < 0xFFFF) {
+        bins[bin]++;
+        total++;
+    }
+}
+
+int8_t NoiseHistogram::median() const {
+    int seen = 0;
+    for (int i = 0; i < NOISE_HIST_BINS; i++) {
+        seen += bins[i];
+        if (seen * 2 >= total) return (int8_t)(NOISE_HIST_MIN_DBM + i);
+    }
+    return 0;
+}
+
+void NoiseFloorEstimator::add(int8_t captureMedianDbm) {
+    window[next] = captureMedianDbm;
+    next = (next + 1) % NOISE_WINDOW;
+    if (filled < NOISE_WINDOW) filled++;
+}
+
+int8_t NoiseFloorEstimator::median() {
+    if (filled == 0) return 0;
+
+    int8_t sorted[NOISE_WINDOW];
+    memcpy(sorted, window, filled);
+    for (int i = 1; i < filled; i++) {
+        int8_t v = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    return sorted[filled / 2];
+}
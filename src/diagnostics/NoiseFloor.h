@@ -0,0 +1,44 @@
+#ifndef NOISE_FLOOR_H
+#define NOISE_FLOOR_H
+
+#include <stdint.h>
+
+#define NOISE_WINDOW 16           // captures kept in the rolling window
+#define NOISE_HIST_MIN_DBM -120
+#define NOISE_HIST_BINS 64        // -120 .. -57 dBm
+
+/**
+ * Per-capture histogram of rx_ctrl.noise_floor. Every captured frame adds
+ * one sample; median() gives the capture's value without storing frames.
+ */
+class NoiseHistogram {
+public:
+    NoiseHistogram() { reset(); }
+    void reset();
+    void add(int8_t dbm);
+    int count() const { return total; }
+    int8_t median() const;
+
+private:
+    uint16_t bins[NOISE_HIST_BINS];
+    int total;
+};
+
+/**
+ * Rolling noise floor for the associated channel: the median of the last
+ * NOISE_WINDOW capture medians, so one burst of interference or a single
+ * odd capture does not move the reported value.
+ */
+class NoiseFloorEstimator {
+public:
+    static void add(int8_t captureMedianDbm);
+    static bool valid() { return filled > 0; }
+    static int8_t median();
+
+private:
+    static int8_t window[NOISE_WINDOW];
+    static int next;
+    static int filled;
+};
+
+#endif
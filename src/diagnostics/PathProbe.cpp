@@ -0,0 +1,130 @@
+#include "PathProbe.h"
+
+// Sequence numbers carry the round in the high byte and the TTL in the low one
+#define PATH_SEQ(round, ttl) (uint16_t)(((round) << 8) | (ttl))
+
+/**
+ * Returns the quoted sequence number, or -1 if the packet is not about one
+ * of our probes. Time Exceeded and Destination Unreachable quote the
+ * original IP header plus the first 8 bytes of our echo request.
+ */
+int PathProbe::parseReply(const uint8_t* buf, int len, uint16_t id, uint32_t target,
+                          uint32_t* fromIp, bool* fromTarget) {
+    if (len < 20) return -1;
+    int ipHeaderLen = (buf[0] & 0x0F) * 4;
+    if (len < ipHeaderLen + (int)sizeof(IcmpEchoHeader)) return -1;
+
+    memcpy(fromIp, buf + 12, 4);
+    const IcmpEchoHeader* hdr = (const IcmpEchoHeader*)(buf + ipHeaderLen);
+
+    if (hdr->type == ICMP_TYPE_ECHO_REPLY) {
+        if (ntohs(hdr->id) != id || *fromIp != target) return -1;
+        *fromTarget = true;
+        return ntohs(hdr->seq);
+    }
+    if (hdr->type != ICMP_TYPE_TIME_EXCEEDED && hdr->type != ICMP_TYPE_DEST_UNREACHABLE) return -1;
+
+    // Quoted datagram follows the 8-byte ICMP error header
+    const uint8_t* inner = buf + ipHeaderLen + 8;
+    int innerLen = len - ipHeaderLen - 8;
+    if (innerLen < 20) return -1;
+    int innerHeaderLen = (inner[0] & 0x0F) * 4;
+    if (innerLen < innerHeaderLen + (int)sizeof(IcmpEchoHeader)) return -1;
+    if (inner[9] != IPPROTO_ICMP) return -1;
+
+    uint32_t innerDst;
+    memcpy(&innerDst, inner + 16, 4);
+    const IcmpEchoHeader* quoted = (const IcmpEchoHeader*)(inner + innerHeaderLen);
+    if (innerDst != target || quoted->type != ICMP_TYPE_ECHO_REQUEST || ntohs(quoted->id) != id) return -1;
+
+    // An unreachable from the target itself still means we got there
+    *fromTarget = *fromIp == target;
+    return ntohs(quoted->seq);
+}
+
+bool PathProbe::trace(uint32_t ip, const PathProbeConfig& cfg, PathResult& out) {
+    memset(&out, 0, sizeof(out));
+    out.target = ip;
+
+    int maxHops = cfg.maxHops;
+    if (maxHops < 1) maxHops = 1;
+    if (maxHops > PATH_MAX_HOPS) maxHops = PATH_MAX_HOPS;
+    int rounds = cfg.probesPerHop;
+    if (rounds < 1) rounds = 1;
+    if (rounds > PATH_MAX_PROBES_PER_HOP) rounds = PATH_MAX_PROBES_PER_HOP;
+
+    for (int h = 0; h < maxHops; h++) out.hops[h].rttMs = -1;
+
+    int sock = IcmpEngine::openRawSocket();
+    if (sock < 0) return false;
+    uint16_t id = (uint16_t)(netRandom() & 0xFFFF);
+
+    uint32_t sentAt[PATH_MAX_PROBES_PER_HOP][PATH_MAX_HOPS];
+    int reachedTtl = 0;
+    int lastAnswered = 0;
+
+    uint32_t start = netMicros();
+    uint32_t intervalUs = (uint32_t)cfg.intervalMs * 1000;
+    uint32_t deadlineUs = (uint32_t)(rounds - 1) * intervalUs + (uint32_t)cfg.timeoutMs * 1000;
+    int nextRound = 0;
+
+    for (;;) {
+        uint32_t elapsed = netMicros() - start;
+        if (elapsed >= deadlineUs) break;
+
+        if (nextRound < rounds && elapsed >= (uint32_t)nextRound * intervalUs) {
+            // Past a known destination there is nothing new to learn
+            int lastTtl = reachedTtl > 0 ? reachedTtl : maxHops;
+            for (int ttl = 1; ttl <= lastTtl; ttl++) {
+                int value = ttl;
+                setsockopt(sock, IPPROTO_IP, IP_TTL, &value, sizeof(value));
+                sentAt[nextRound][ttl - 1] = netMicros();
+                IcmpEngine::sendEcho(sock, ip, id, PATH_SEQ(nextRound, ttl));
+            }
+            nextRound++;
+            continue;
+        }
+
+        uint32_t waitUs = deadlineUs - elapsed;
+        if (nextRound < rounds) {
+            uint32_t untilSend = (uint32_t)nextRound * intervalUs - elapsed;
+            if (untilSend < waitUs) waitUs = untilSend;
+        }
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(sock, &readSet);
+        struct timeval tv;
+        tv.tv_sec = waitUs / 1000000;
+        tv.tv_usec = waitUs % 1000000;
+        if (select(sock + 1, &readSet, NULL, NULL, &tv) <= 0) continue;
+
+        uint8_t buf[160];
+        int len;
+        while ((len = recv(sock, buf, sizeof(buf), 0)) > 0) {
+            uint32_t now = netMicros();
+            uint32_t from = 0;
+            bool fromTarget = false;
+            int seq = parseReply(buf, len, id, ip, &from, &fromTarget);
+            if (seq < 0) continue;
+
+            int round = seq >> 8;
+            int ttl = seq & 0xFF;
+            if (round >= nextRound || ttl < 1 || ttl > maxHops) continue;
+
+            PathHop& hop = out.hops[ttl - 1];
+            float rtt = (now - sentAt[round][ttl - 1]) / 1000.0f;
+            if (hop.rttMs < 0 || rtt < hop.rttMs) hop.rttMs = rtt;
+            hop.ip = from;
+            hop.replies++;
+
+            if (ttl > lastAnswered) lastAnswered = ttl;
+            if (fromTarget && (reachedTtl == 0 || ttl < reachedTtl)) reachedTtl = ttl;
+        }
+    }
+    close(sock);
+
+    out.reached = reachedTtl > 0;
+    out.hopCount = out.reached ? reachedTtl : lastAnswered;
+    return out.hopCount > 0;
+}
@@ -0,0 +1,48 @@
+#ifndef PATH_PROBE_H
+#define PATH_PROBE_H
+
+#include "NetCompat.h"
+#include "IcmpEngine.h"
+
+#define PATH_MAX_HOPS 16
+#define PATH_MAX_PROBES_PER_HOP 3
+#define ICMP_TYPE_DEST_UNREACHABLE 3
+#define ICMP_TYPE_TIME_EXCEEDED 11
+
+struct PathProbeConfig {
+    int maxHops;        // TTLs 1..maxHops, capped at PATH_MAX_HOPS
+    int probesPerHop;   // rounds, capped at PATH_MAX_PROBES_PER_HOP
+    int intervalMs;     // spacing between rounds
+    int timeoutMs;      // wait after the last round
+};
+
+struct PathHop {
+    uint32_t ip;        // responding router, 0 if every probe went unanswered
+    float rttMs;        // best of the probes, -1 if none answered
+    uint8_t replies;
+};
+
+struct PathResult {
+    uint32_t target;
+    bool reached;       // the target itself answered
+    int hopCount;       // up to the target, or the last hop that answered
+    PathHop hops[PATH_MAX_HOPS];   // index 0 is TTL 1
+};
+
+/**
+ * Traceroute-lite. Each round sends one echo request per TTL, all at once,
+ * from a single raw socket; routers answer with Time Exceeded quoting our
+ * identifier and sequence (round and TTL), the target with an echo reply.
+ * A whole path therefore costs one timeout, not one per hop.
+ */
+class PathProbe {
+public:
+    // ip is in network byte order
+    static bool trace(uint32_t ip, const PathProbeConfig& cfg, PathResult& out);
+
+private:
+    static int parseReply(const uint8_t* buf, int len, uint16_t id, uint32_t target,
+                          uint32_t* fromIp, bool* fromTarget);
+};
+
+#endif
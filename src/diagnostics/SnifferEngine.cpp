@@ -1,59 +1,288 @@
 #include "SnifferEngine.h"
+#include "Airtime.h"
+#include "BeaconTracker.h"
+#include "../connection/LinkMonitor.h"
 #include <WiFi.h>
 
-// Static variables to hold data during the asynchronous callback
-static volatile int totalPackets = 0;
-static volatile int beaconPackets = 0;
-static volatile uint32_t lastSeq = 0;
-static volatile int seqGaps = 0;
-
-void SnifferEngine::snifferCallback(void* buf, wifi_promiscuous_pkt_type_t type) {
-    totalPackets++;
-    
-    // We only care about Management Frames (Beacons)
-    if (type == WIFI_PKT_MGMT) {
-        wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
-        uint8_t *payload = pkt->payload;
-        
-        // Frame Control: Subtype 0x08 is a Beacon
-        if ((payload[0] & 0xFC) == 0x80) {
-            beaconPackets++;
-            
-            // Extract Sequence Number (2 bytes at offset 22)
-            uint16_t seq = ((payload[23] << 8) | payload[22]) >> 4;
-            if (lastSeq != 0 && seq > lastSeq + 1) {
-                seqGaps += (seq - lastSeq - 1);
-            }
-            lastSeq = seq;
+// Ordinary static storage lands in internal DRAM, which the IRAM callback
+// can touch while the flash cache is disabled.
+FrameRing SnifferEngine::ring;
+int32_t SnifferEngine::rssiSum = 0;
+uint8_t SnifferEngine::ownBssid[6] = {0};
+bool SnifferEngine::haveOwnBssid = false;
+int SnifferEngine::ownChannel = 0;
+bool SnifferEngine::sessionAssociated = false;
+NoiseHistogram SnifferEngine::noise;
+uint32_t SnifferEngine::airtimeUs[3] = {0, 0, 0};
+
+static inline uint32_t IRAM_ATTR fnv1a(const uint8_t* p, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Runs in the Wi-Fi driver task. Does a fixed amount of work per frame:
+ * summarize the header and push it; all aggregation happens in the
+ * capturing task via consume().
+ */
+void IRAM_ATTR SnifferEngine::snifferCallback(void* buf, wifi_promiscuous_pkt_type_t type) {
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    const uint8_t* payload = pkt->payload;
+    int len = pkt->rx_ctrl.sig_len;
+
+    if (len < 10) return;   // shorter than any frame with an address
+
+    FrameSummary f;
+    f.timestampUs = pkt->rx_ctrl.timestamp;
+    f.len = (uint16_t)len;
+    f.rssi = (int8_t)pkt->rx_ctrl.rssi;
+    f.noiseFloor = (int8_t)pkt->rx_ctrl.noise_floor;
+    f.fc = payload[0];
+    f.flags = 0;
+    if (pkt->rx_ctrl.sig_mode != 0) {
+        f.rate = (uint8_t)pkt->rx_ctrl.mcs;
+        f.flags |= FRAME_FLAG_HT;
+        if (pkt->rx_ctrl.cwb) f.flags |= FRAME_FLAG_40MHZ;
+        if (pkt->rx_ctrl.sgi) f.flags |= FRAME_FLAG_SGI;
+        if (pkt->rx_ctrl.aggregation) f.flags |= FRAME_FLAG_AMPDU;
+    } else {
+        f.rate = (uint8_t)pkt->rx_ctrl.rate;
+    }
+    if (payload[1] & 0x01) f.flags |= FRAME_FLAG_TODS;
+    if (payload[1] & 0x02) f.flags |= FRAME_FLAG_FROMDS;
+    if (payload[1] & 0x08) f.flags |= FRAME_FLAG_RETRY;
+    if (payload[1] & 0x40) f.flags |= FRAME_FLAG_PROTECTED;
+
+    const uint8_t* bssid = nullptr;
+    f.beaconIntervalTu = 0;
+
+    if (FRAME_TYPE(f.fc) == FRAME_TYPE_CTRL) {
+        // ACK/CTS carry only addr1; RTS, BlockAck etc. also carry addr2
+        f.addrHash = fnv1a(payload + 4, len >= 20 ? 12 : 6);
+        f.seq = 0;
+    } else if (len >= 24) {
+        f.addrHash = fnv1a(payload + 4, 18);
+        f.seq = ((payload[23] << 8) | payload[22]) >> 4;
+
+        switch (payload[1] & 0x03) {
+        case 0x00: bssid = payload + 16; break;   // addr3
+        case 0x01: bssid = payload + 4; break;    // to DS: addr1
+        case 0x02: bssid = payload + 10; break;   // from DS: addr2
+        }
+        // Beacon body: 8 byte timestamp, then the interval in TU
+        if ((f.fc & 0xFC) == 0x80 && len >= 36) {
+            f.beaconIntervalTu = payload[32] | (payload[33] << 8);
+        }
+    } else {
+        return;
+    }
+
+    if (bssid) {
+        memcpy(f.bssid, bssid, 6);
+    } else {
+        memset(f.bssid, 0, 6);
+    }
+
+    ring.push(f);
+}
+
+void SnifferEngine::consume(const FrameSummary& f, SnifferStats& stats) {
+    stats.totalFrames++;
+    rssiSum += f.rssi;
+    noise.add(f.noiseFloor);
+    if (f.flags & FRAME_FLAG_RETRY) stats.retryFrames++;
+
+    uint8_t type = FRAME_TYPE(f.fc);
+    if (type <= FRAME_TYPE_DATA) airtimeUs[type] += frameAirtimeUs(f);
+
+    switch (type) {
+    case FRAME_TYPE_MGMT:
+        stats.mgmtFrames++;
+        if ((f.fc & 0xFC) == 0x80) {   // Beacon
+            stats.beaconCount++;
+            BeaconTracker::record(f);
         }
+        break;
+    case FRAME_TYPE_CTRL:
+        stats.ctrlFrames++;
+        break;
+    case FRAME_TYPE_DATA:
+        stats.dataPackets++;
+        break;
     }
 }
 
-SnifferStats SnifferEngine::analyzeChannel(int channel, uint32_t durationMs) {
-    SnifferStats stats = {0};
-    
-    // Reset counters
-    totalPackets = 0; beaconPackets = 0; lastSeq = 0; seqGaps = 0;
-    
-    // Disconnect and enter Promiscuous Mode
-    WiFi.disconnect();
+/**
+ * Splits beacon loss into our own AP and everyone else. missedBeacons keeps
+ * its old meaning (all APs on the channel) but is now summed per BSSID.
+ */
+void SnifferEngine::summarizeBeacons(const uint8_t* ownBssid, SnifferStats& stats) {
+    ApBeaconStats own;
+    stats.ownApSeen = ownBssid && BeaconTracker::lookup(ownBssid, own);
+    if (stats.ownApSeen) {
+        stats.ownAp = own;
+    } else {
+        memset(&stats.ownAp, 0, sizeof(stats.ownAp));
+        if (ownBssid) memcpy(stats.ownAp.bssid, ownBssid, 6);
+    }
+
+    int nbrBeacons, nbrMissed;
+    BeaconTracker::neighborTotals(ownBssid, nbrBeacons, nbrMissed);
+    stats.neighborApCount = BeaconTracker::apCount() - (stats.ownApSeen ? 1 : 0);
+    int expected = nbrBeacons + nbrMissed;
+    stats.neighborBeaconLossPct = expected > 0 ? 100.0f * nbrMissed / expected : 0;
+    stats.neighborCount = BeaconTracker::neighbors(ownBssid, stats.neighbors, BEACON_MAX_REPORTED);
+
+    stats.missedBeacons = nbrMissed + (stats.ownApSeen ? own.missed : 0);
+}
+
+/**
+ * Enters promiscuous mode once. Our own BSSID is remembered first so the
+ * captures can tell our AP apart from the neighbors. In associated mode the
+ * station stays connected and promiscuous RX runs alongside it on the AP's
+ * channel; off-channel mode disconnects so the radio can be retuned.
+ */
+void SnifferEngine::beginSession(SniffMode mode) {
+    ring.reset();
+
+    haveOwnBssid = WiFi.isConnected() && WiFi.BSSID();
+    if (haveOwnBssid) {
+        memcpy(ownBssid, WiFi.BSSID(), 6);
+        ownChannel = WiFi.channel();
+    }
+    sessionAssociated = mode == SNIFF_ASSOCIATED && WiFi.isConnected();
+
+    // Control frames are needed for the airtime estimate (ACK/RTS/CTS/BlockAck)
+    wifi_promiscuous_filter_t filter;
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT | WIFI_PROMIS_FILTER_MASK_CTRL |
+                         WIFI_PROMIS_FILTER_MASK_DATA;
+
+    if (!sessionAssociated && WiFi.isConnected()) {
+        LinkMonitor::expectDisconnect();
+        WiFi.disconnect();
+    }
+    esp_wifi_set_promiscuous_filter(&filter);
     esp_wifi_set_promiscuous(true);
     esp_wifi_set_promiscuous_rx_cb(&snifferCallback);
-    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
-
-    delay(durationMs); // Sniffing window
+}
 
-    // Exit Promiscuous Mode
+void SnifferEngine::endSession() {
     esp_wifi_set_promiscuous(false);
-    
-    // Calculate results
-    stats.beaconCount = beaconPackets;
-    stats.missedBeacons = seqGaps;
-    stats.dataPackets = totalPackets - beaconPackets;
-    
-    // utilization estimation: packet density over time
-    stats.channelUtilization = (totalPackets / (float)durationMs) * 100.0;
+}
+
+/**
+ * One dwell on one channel inside an open session. Frames still queued
+ * from the previous channel are discarded before the window starts.
+ */
+void SnifferEngine::capture(int channel, uint32_t durationMs, SnifferStats& stats) {
+    FrameSummary f;
+    memset(&stats, 0, sizeof(stats));
+
+    // Retuning while associated would take the link down with it
+    if (sessionAssociated) {
+        channel = WiFi.channel();
+    } else {
+        esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    }
+    stats.channel = channel;
+    stats.associated = sessionAssociated;
+    while (ring.pop(f)) {}
+
+    BeaconTracker::reset();
+    noise.reset();
+    rssiSum = 0;
+    airtimeUs[0] = airtimeUs[1] = airtimeUs[2] = 0;
+    uint32_t droppedBefore = ring.dropped();
+
+    // Sniffing window: drain the ring as we go so it never fills up
+    uint32_t start = micros();
+    while (micros() - start < durationMs * 1000) {
+        while (ring.pop(f)) consume(f, stats);
+        vTaskDelay(pdMS_TO_TICKS(SNIFFER_DRAIN_INTERVAL_MS));
+    }
+    uint32_t windowUs = micros() - start;
+    while (ring.pop(f)) consume(f, stats);
+
+    stats.droppedFrames = ring.dropped() - droppedBefore;
+    stats.avgRssi = stats.totalFrames > 0 ? (float)rssiSum / stats.totalFrames : 0;
+
+    summarizeBeacons(haveOwnBssid ? ownBssid : nullptr, stats);
+
+    // Only our own channel feeds the rolling estimate used for SNR
+    stats.noiseSamples = noise.count();
+    stats.noiseFloor = stats.noiseSamples > 0 ? noise.median() : 0;
+    if (stats.noiseSamples > 0 && haveOwnBssid && channel == ownChannel) {
+        NoiseFloorEstimator::add(stats.noiseFloor);
+    }
+
+    // Busy time as a share of the observation window. Frames lost to ring
+    // overflow are not counted, so this is a lower bound when dropped > 0.
+    stats.mgmtBusyPct = 100.0f * airtimeUs[FRAME_TYPE_MGMT] / windowUs;
+    stats.ctrlBusyPct = 100.0f * airtimeUs[FRAME_TYPE_CTRL] / windowUs;
+    stats.dataBusyPct = 100.0f * airtimeUs[FRAME_TYPE_DATA] / windowUs;
+    stats.channelUtilization = stats.mgmtBusyPct + stats.ctrlBusyPct + stats.dataBusyPct;
     stats.channelUtilization = constrain(stats.channelUtilization, 0.0, 100.0);
+}
 
+SnifferStats SnifferEngine::analyzeChannel(int channel, uint32_t durationMs, SniffMode mode) {
+    SnifferStats stats;
+    beginSession(mode);
+    capture(channel, durationMs, stats);
+    endSession();
     return stats;
-}
\ No newline at end of file
+}
+
+bool SnifferEngine::sampleNoiseFloor(uint32_t durationMs) {
+    if (!WiFi.isConnected()) return false;
+
+    SnifferStats stats;
+    beginSession(SNIFF_ASSOCIATED);
+    capture(0, durationMs, stats);
+    endSession();
+    return stats.noiseSamples > 0;
+}
+
+SweepSchedule SnifferEngine::defaultSchedule(uint16_t dwellMs, uint16_t primaryDwellMs) {
+    SweepSchedule sched;
+    for (int ch = 1; ch <= SWEEP_MAX_CHANNEL; ch++) {
+        bool primary = ch == 1 || ch == 6 || ch == 11;
+        sched.dwellMs[ch - 1] = primary ? primaryDwellMs : dwellMs;
+    }
+    return sched;
+}
+
+/**
+ * Visits every channel with a non-zero dwell in one promiscuous session
+ * and keeps only the per-channel summary.
+ */
+ChannelSweep SnifferEngine::sweepChannels(const SweepSchedule& sched) {
+    ChannelSweep sweep;
+    sweep.count = 0;
+
+    beginSession(SNIFF_OFFCHANNEL);
+    for (int ch = 1; ch <= SWEEP_MAX_CHANNEL; ch++) {
+        uint16_t dwell = sched.dwellMs[ch - 1];
+        if (dwell == 0) continue;
+
+        SnifferStats stats;
+        capture(ch, dwell, stats);
+
+        int beacons, missed;
+        BeaconTracker::neighborTotals(nullptr, beacons, missed);
+        int expected = beacons + missed;
+
+        ChannelUsage& u = sweep.channels[sweep.count++];
+        u.channel = ch;
+        u.dwellMs = dwell;
+        u.utilization = stats.channelUtilization;
+        u.apCount = BeaconTracker::apCount();
+        u.beaconLossPct = expected > 0 ? 100.0f * missed / expected : 0;
+    }
+    endSession();
+
+    return sweep;
+}
@@ -3,19 +3,91 @@
 
 #include <Arduino.h>
 #include <esp_wifi.h>
+#include "FrameRing.h"
+#include "BeaconTracker.h"
+#include "NoiseFloor.h"
+
+#define SNIFFER_DRAIN_INTERVAL_MS 10
+#define SWEEP_MAX_CHANNEL 13
+#define SWEEP_DEFAULT_DWELL_MS 150
+#define SWEEP_PRIMARY_DWELL_MS 400   // channels 1, 6 and 11
 
 struct SnifferStats {
-    float channelUtilization; // 0-100%
+    float channelUtilization; // 0-100%, estimated airtime / window
+    float mgmtBusyPct;
+    float ctrlBusyPct;
+    float dataBusyPct;
     int beaconCount;
     int missedBeacons;
     int dataPackets;
+    int totalFrames;
+    int mgmtFrames;
+    int ctrlFrames;
+    int retryFrames;
+    float avgRssi;
+    uint32_t droppedFrames;   // ring overflow, not radio loss
+    bool associated;          // captured without leaving the AP
+    int8_t noiseFloor;        // median rx_ctrl.noise_floor, dBm; 0 if no frames
+    int noiseSamples;
+    int channel;              // channel actually captured
+    bool ownApSeen;
+    ApBeaconStats ownAp;      // beacons from the AP we were associated with
+    int neighborApCount;
+    float neighborBeaconLossPct;  // pooled over all other APs
+    int neighborCount;        // entries used in neighbors[]
+    ApBeaconStats neighbors[BEACON_MAX_REPORTED];  // strongest first
+};
+
+enum SniffMode {
+    SNIFF_ASSOCIATED,   // stay on the AP's channel, keep the link up
+    SNIFF_OFFCHANNEL    // drop the association so any channel can be tuned
+};
+
+// Dwell per channel, indexed by channel - 1; 0 skips the channel
+struct SweepSchedule {
+    uint16_t dwellMs[SWEEP_MAX_CHANNEL];
+};
+
+struct ChannelUsage {
+    uint8_t channel;
+    uint8_t apCount;          // BSSIDs heard beaconing
+    uint16_t dwellMs;
+    float utilization;        // airtime %, as in SnifferStats
+    float beaconLossPct;      // pooled over every AP on the channel
+};
+
+struct ChannelSweep {
+    int count;
+    ChannelUsage channels[SWEEP_MAX_CHANNEL];
 };
 
 class SnifferEngine {
 public:
-    static SnifferStats analyzeChannel(int channel, uint32_t durationMs);
+    // In SNIFF_ASSOCIATED mode a connected probe captures its own channel
+    // regardless of the channel argument; off-channel needs SNIFF_OFFCHANNEL.
+    static SnifferStats analyzeChannel(int channel, uint32_t durationMs,
+                                       SniffMode mode = SNIFF_ASSOCIATED);
+    // Short associated capture that only refreshes NoiseFloorEstimator
+    static bool sampleNoiseFloor(uint32_t durationMs);
+    // Always off-channel: the caller reconnects afterwards if needed
+    static ChannelSweep sweepChannels(const SweepSchedule& sched);
+    static SweepSchedule defaultSchedule(uint16_t dwellMs = SWEEP_DEFAULT_DWELL_MS,
+                                         uint16_t primaryDwellMs = SWEEP_PRIMARY_DWELL_MS);
 private:
+    static void beginSession(SniffMode mode);
+    static void endSession();
+    static void capture(int channel, uint32_t durationMs, SnifferStats& stats);
     static void snifferCallback(void* buf, wifi_promiscuous_pkt_type_t type);
+    static void consume(const FrameSummary& f, SnifferStats& stats);
+    static void summarizeBeacons(const uint8_t* ownBssid, SnifferStats& stats);
+    static FrameRing ring;
+    static int32_t rssiSum;
+    static uint32_t airtimeUs[3];   // indexed by FRAME_TYPE_*
+    static uint8_t ownBssid[6];
+    static bool haveOwnBssid;
+    static int ownChannel;
+    static bool sessionAssociated;
+    static NoiseHistogram noise;
 };
 
-#endif
\ No newline at end of file
+#endif
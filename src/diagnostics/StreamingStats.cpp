@@ -0,0 +1,113 @@
+#include "StreamingStats.h"
+#include <math.h>
+
+void P2Quantile::reset(float quantile) {
+    p = quantile;
+    n = 0;
+    for (int i = 0; i < 5; i++) {
+        q[i] = 0;
+        pos[i] = i + 1;
+    }
+    desired[0] = 1;
+    desired[1] = 1 + 2 * p;
+    desired[2] = 1 + 4 * p;
+    desired[3] = 3 + 2 * p;
+    desired[4] = 5;
+    inc[0] = 0;
+    inc[1] = p / 2;
+    inc[2] = p;
+    inc[3] = (1 + p) / 2;
+    inc[4] = 1;
+}
+
+float P2Quantile::parabolic(int i, float d) const {
+    return q[i] + d / (pos[i + 1] - pos[i - 1]) *
+           ((pos[i] - pos[i - 1] + d) * (q[i + 1] - q[i]) / (pos[i + 1] - pos[i]) +
+            (pos[i + 1] - pos[i] - d) * (q[i] - q[i - 1]) / (pos[i] - pos[i - 1]));
+}
+
+float P2Quantile::linear(int i, int d) const {
+    return q[i] + d * (q[i + d] - q[i]) / (pos[i + d] - pos[i]);
+}
+
+void P2Quantile::add(float x) {
+    // Warm-up: keep the first five samples sorted in the marker array
+    if (n < 5) {
+        int i = n++;
+        while (i > 0 && q[i - 1] > x) {
+            q[i] = q[i - 1];
+            i--;
+        }
+        q[i] = x;
+        return;
+    }
+
+    int k;
+    if (x < q[0]) {
+        q[0] = x;
+        k = 0;
+    } else if (x >= q[4]) {
+        q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && x >= q[k + 1]) k++;
+    }
+
+    for (int i = k + 1; i < 5; i++) pos[i] += 1;
+    for (int i = 0; i < 5; i++) desired[i] += inc[i];
+    n++;
+
+    // Move the three middle markers towards their desired positions
+    for (int i = 1; i <= 3; i++) {
+        float d = desired[i] - pos[i];
+        if ((d >= 1 && pos[i + 1] - pos[i] > 1) || (d <= -1 && pos[i - 1] - pos[i] < -1)) {
+            int step = d > 0 ? 1 : -1;
+            float candidate = parabolic(i, step);
+            if (q[i - 1] < candidate && candidate < q[i + 1]) {
+                q[i] = candidate;
+            } else {
+                q[i] = linear(i, step);
+            }
+            pos[i] += step;
+        }
+    }
+}
+
+float P2Quantile::value() const {
+    if (n == 0) return 0;
+    if (n < 5) {
+        // Nearest rank over the sorted warm-up samples
+        int rank = (int)ceilf(p * n);
+        if (rank < 1) rank = 1;
+        return q[rank - 1];
+    }
+    return q[2];
+}
+
+void MetricSummary::reset() {
+    n = 0;
+    minV = 0;
+    maxV = 0;
+    sum = 0;
+    p50.reset(0.5f);
+    p95.reset(0.95f);
+}
+
+void MetricSummary::add(float x) {
+    if (n == 0 || x < minV) minV = x;
+    if (n == 0 || x > maxV) maxV = x;
+    sum += x;
+    n++;
+    p50.add(x);
+    p95.add(x);
+}
+
+void MetricSummary::snapshot(SampleSummary& out) const {
+    out.count = n;
+    out.min = minV;
+    out.max = maxV;
+    out.mean = n > 0 ? (float)(sum / n) : 0;
+    out.p50 = p50.value();
+    out.p95 = p95.value();
+}
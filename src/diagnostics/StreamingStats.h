@@ -0,0 +1,59 @@
+#ifndef STREAMING_STATS_H
+#define STREAMING_STATS_H
+
+#include <stdint.h>
+
+/**
+ * P-square single-quantile estimator (Jain & Chlamtac, 1985). Five markers,
+ * constant memory and O(1) per sample regardless of how many samples an
+ * interval collects. Exact for the first five samples.
+ */
+class P2Quantile {
+public:
+    explicit P2Quantile(float quantile = 0.5f) { reset(quantile); }
+    void reset(float quantile);
+    void add(float x);
+    float value() const;
+    int count() const { return n; }
+
+private:
+    float parabolic(int i, float d) const;
+    float linear(int i, int d) const;
+
+    float p;
+    int n;
+    float q[5];        // marker heights
+    float pos[5];      // actual marker positions
+    float desired[5];  // desired marker positions
+    float inc[5];      // desired position increments
+};
+
+// Plain-old-data snapshot so it can travel inside NetworkMetrics
+struct SampleSummary {
+    int count;
+    float min;
+    float mean;
+    float p50;
+    float p95;
+    float max;
+};
+
+// min / mean / p50 / p95 / max over one report interval in fixed memory
+class MetricSummary {
+public:
+    MetricSummary() { reset(); }
+    void reset();
+    void add(float x);
+    void snapshot(SampleSummary& out) const;
+    int count() const { return n; }
+
+private:
+    int n;
+    float minV;
+    float maxV;
+    double sum;
+    P2Quantile p50;
+    P2Quantile p95;
+};
+
+#endif
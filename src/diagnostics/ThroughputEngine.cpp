@@ -0,0 +1,122 @@
+#include "ThroughputEngine.h"
+#include <stdio.h>
+
+uint8_t ThroughputEngine::buffer[THROUGHPUT_BUFFER_SIZE];
+
+/**
+ * Goodput excludes the warm-up window. If the transfer finished before the
+ * warm-up elapsed (small object, fast link) the whole transfer is used.
+ */
+void ThroughputEngine::finish(ThroughputResult& out, uint32_t startUs, uint32_t warmEndUs,
+                              long warmBytes, uint32_t endUs) {
+    uint32_t spanUs;
+    if (warmEndUs != 0) {
+        out.measuredBytes = out.bytes - warmBytes;
+        spanUs = endUs - warmEndUs;
+    } else {
+        out.measuredBytes = out.bytes;
+        spanUs = endUs - startUs;
+    }
+    if (spanUs == 0) spanUs = 1;
+
+    out.measuredMs = spanUs / 1000;
+    out.goodputKbps = out.measuredBytes > 0 ? (out.measuredBytes * 8.0f * 1000.0f) / spanUs : -1;
+}
+
+bool ThroughputEngine::download(uint32_t ip, const HttpUrl& url, const ThroughputConfig& cfg, ThroughputResult& out) {
+    memset(&out, 0, sizeof(out));
+    out.status = -1;
+    out.goodputKbps = -1;
+
+    HttpSession session;
+    if (!session.connectTo(ip, url.port, cfg.timeoutMs)) return false;
+
+    char request[HTTP_PATH_LEN + HTTP_HOST_LEN + 64];
+    int len = snprintf(request, sizeof(request),
+                       "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                       url.path, url.host);
+    if (!session.sendAll(request, len, cfg.timeoutMs)) return false;
+
+    HttpResponseHead head;
+    if (!session.readHead(buffer, sizeof(buffer), cfg.timeoutMs, head)) return false;
+    out.status = head.status;
+    if (head.status < 200 || head.status >= 300) return false;
+
+    uint32_t startUs = netMicros();
+    uint32_t warmEndUs = 0;
+    long warmBytes = 0;
+    uint32_t durationUs = (uint32_t)cfg.durationMs * 1000;
+    uint32_t warmupUs = (uint32_t)cfg.warmupMs * 1000;
+
+    // Chunked bodies count payload only; the framing is not goodput
+    HttpChunkDecoder chunks;
+    long buffered = head.bufferedLen - head.bodyOffset;
+    out.bytes = head.chunked ? chunks.feed(buffer + head.bodyOffset, buffered) : buffered;
+
+    for (;;) {
+        uint32_t elapsed = netMicros() - startUs;
+        if (warmEndUs == 0 && elapsed >= warmupUs) {
+            warmEndUs = netMicros();
+            warmBytes = out.bytes;
+        }
+        if (elapsed >= durationUs || out.bytes >= cfg.byteBudget) break;
+        if (head.chunked && (chunks.done() || chunks.failed())) break;
+        if (head.contentLength >= 0 && out.bytes >= head.contentLength) break;
+
+        int n = session.recvSome(buffer, sizeof(buffer), cfg.timeoutMs);
+        if (n <= 0) break;
+        out.bytes += head.chunked ? chunks.feed(buffer, n) : n;
+    }
+
+    finish(out, startUs, warmEndUs, warmBytes, netMicros());
+    return out.bytes > 0;
+}
+
+bool ThroughputEngine::upload(uint32_t ip, const HttpUrl& url, const ThroughputConfig& cfg, ThroughputResult& out) {
+    memset(&out, 0, sizeof(out));
+    out.status = -1;
+    out.goodputKbps = -1;
+
+    HttpSession session;
+    if (!session.connectTo(ip, url.port, cfg.timeoutMs)) return false;
+
+    char request[HTTP_PATH_LEN + HTTP_HOST_LEN + 128];
+    int len = snprintf(request, sizeof(request),
+                       "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/octet-stream\r\n"
+                       "Content-Length: %ld\r\nConnection: close\r\n\r\n",
+                       url.path, url.host, cfg.byteBudget);
+    if (!session.sendAll(request, len, cfg.timeoutMs)) return false;
+
+    memset(buffer, 'x', sizeof(buffer));
+
+    uint32_t startUs = netMicros();
+    uint32_t warmEndUs = 0;
+    long warmBytes = 0;
+    uint32_t durationUs = (uint32_t)cfg.durationMs * 1000;
+    uint32_t warmupUs = (uint32_t)cfg.warmupMs * 1000;
+
+    while (out.bytes < cfg.byteBudget) {
+        uint32_t elapsed = netMicros() - startUs;
+        if (warmEndUs == 0 && elapsed >= warmupUs) {
+            warmEndUs = netMicros();
+            warmBytes = out.bytes;
+        }
+        // Stopping early truncates the declared body; the server just sees a short POST
+        if (elapsed >= durationUs) break;
+
+        long chunk = cfg.byteBudget - out.bytes;
+        if (chunk > (long)sizeof(buffer)) chunk = sizeof(buffer);
+        if (!session.sendAll(buffer, chunk, cfg.timeoutMs)) break;
+        out.bytes += chunk;
+    }
+    uint32_t endUs = netMicros();
+
+    // Only a complete body gets a response worth waiting for
+    HttpResponseHead head;
+    if (out.bytes >= cfg.byteBudget && session.readHead(buffer, sizeof(buffer), cfg.timeoutMs, head)) {
+        out.status = head.status;
+    }
+
+    finish(out, startUs, warmEndUs, warmBytes, endUs);
+    return out.bytes > 0;
+}
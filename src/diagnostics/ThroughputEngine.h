@@ -0,0 +1,42 @@
+#ifndef THROUGHPUT_ENGINE_H
+#define THROUGHPUT_ENGINE_H
+
+#include "NetCompat.h"
+#include "HttpSession.h"
+
+#define THROUGHPUT_BUFFER_SIZE 4096
+
+struct ThroughputConfig {
+    int durationMs;     // stop after this much transfer time
+    long byteBudget;    // or after this many body bytes, whichever is first
+    int warmupMs;       // excluded from the goodput figure (TCP slow start)
+    int timeoutMs;      // connect / idle timeout
+};
+
+struct ThroughputResult {
+    int status;           // HTTP status, -1 if no response
+    long bytes;           // body bytes moved in total
+    long measuredBytes;   // bytes after warm-up
+    uint32_t measuredMs;  // time after warm-up
+    float goodputKbps;    // measuredBytes over measuredMs, -1 on failure
+};
+
+/**
+ * Bulk HTTP download (GET) and upload (POST) over a plain TCP socket.
+ * Data moves through one reusable static buffer in THROUGHPUT_BUFFER_SIZE
+ * chunks, so the result reflects the link rather than per-byte overhead.
+ * Not re-entrant: only one measurement may run at a time.
+ */
+class ThroughputEngine {
+public:
+    // ip is the resolved url.host in network byte order
+    static bool download(uint32_t ip, const HttpUrl& url, const ThroughputConfig& cfg, ThroughputResult& out);
+    static bool upload(uint32_t ip, const HttpUrl& url, const ThroughputConfig& cfg, ThroughputResult& out);
+
+private:
+    static void finish(ThroughputResult& out, uint32_t startUs, uint32_t warmEndUs,
+                       long warmBytes, uint32_t endUs);
+    static uint8_t buffer[THROUGHPUT_BUFFER_SIZE];
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "FleetManager.h"
 #include "../diagnostics/DiagnosticEngine.h"
+#include "../diagnostics/MeasurementTask.h"
 #include "../firmware/OTAManager.h"
+#include "../connection/ConnectionManager.h"
+#include "../packaging/DeltaEncoder.h"
 
 bool FleetManager::initialized = false;
 unsigned long FleetManager::lastStatusReport = 0;
@@ -95,6 +98,15 @@ bool FleetManager::processFleetCommand(String command, JsonDocument& payload, St
     else if (command == "fleet_deep_scan") {
         handleFleetDeepScan(payload, commandId);
     }
+    else if (command == "fleet_channel_sweep") {
+        handleFleetChannelSweep(payload, commandId);
+    }
+    else if (command == "fleet_path_probe") {
+        handleFleetPathProbe(payload, commandId);
+    }
+    else if (command == "fleet_resync") {
+        handleFleetResync(payload, commandId);
+    }
     else if (command == "fleet_reboot") {
         handleFleetReboot(payload, commandId);
     }
@@ -227,11 +239,38 @@ void FleetManager::handleFleetConfig(JsonDocument& payload, String commandId) {
         );
     }
 
-    DynamicJsonDocument filteredDoc(1024);
+    DynamicJsonDocument filteredDoc(2048);
     if (config.containsKey("location")) filteredDoc["location"] = config["location"];
     if (config.containsKey("groups")) filteredDoc["groups"] = config["groups"];
     if (config.containsKey("tags")) filteredDoc["tags"] = config["tags"];
     if (config.containsKey("report_interval")) filteredDoc["report_interval"] = config["report_interval"];
+    if (config.containsKey("targets")) filteredDoc["targets"] = config["targets"];
+    if (config.containsKey("dns_resolvers")) filteredDoc["dns_resolvers"] = config["dns_resolvers"];
+    if (config.containsKey("dns_zone")) filteredDoc["dns_zone"] = config["dns_zone"];
+    if (config.containsKey("dns_names")) filteredDoc["dns_names"] = config["dns_names"];
+    if (config.containsKey("dns_queries")) filteredDoc["dns_queries"] = config["dns_queries"];
+    if (config.containsKey("ping_count")) filteredDoc["ping_count"] = config["ping_count"];
+    if (config.containsKey("ping_interval_ms")) filteredDoc["ping_interval_ms"] = config["ping_interval_ms"];
+    if (config.containsKey("tput_url")) filteredDoc["tput_url"] = config["tput_url"];
+    if (config.containsKey("tput_up_url")) filteredDoc["tput_up_url"] = config["tput_up_url"];
+    if (config.containsKey("tput_duration_ms")) filteredDoc["tput_duration_ms"] = config["tput_duration_ms"];
+    if (config.containsKey("tput_bytes")) filteredDoc["tput_bytes"] = config["tput_bytes"];
+    if (config.containsKey("sample_interval_ms")) filteredDoc["sample_interval_ms"] = config["sample_interval_ms"];
+    if (config.containsKey("event_detect")) filteredDoc["event_detect"] = config["event_detect"];
+    if (config.containsKey("auto_deep_scan")) filteredDoc["auto_deep_scan"] = config["auto_deep_scan"];
+    if (config.containsKey("auto_scan_gap_s")) filteredDoc["auto_scan_gap_s"] = config["auto_scan_gap_s"];
+    if (config.containsKey("adaptive_interval")) filteredDoc["adaptive_interval"] = config["adaptive_interval"];
+    if (config.containsKey("interval_min_s")) filteredDoc["interval_min_s"] = config["interval_min_s"];
+    if (config.containsKey("interval_max_s")) filteredDoc["interval_max_s"] = config["interval_max_s"];
+    if (config.containsKey("http_urls")) filteredDoc["http_urls"] = config["http_urls"];
+    if (config.containsKey("path_probe")) filteredDoc["path_probe"] = config["path_probe"];
+    if (config.containsKey("path_max_hops")) filteredDoc["path_max_hops"] = config["path_max_hops"];
+    if (config.containsKey("cycle_budget_ms")) filteredDoc["cycle_budget_ms"] = config["cycle_budget_ms"];
+    if (config.containsKey("telemetry_encoding")) filteredDoc["telemetry_encoding"] = config["telemetry_encoding"];
+    if (config.containsKey("telemetry_delta")) filteredDoc["telemetry_delta"] = config["telemetry_delta"];
+    if (config.containsKey("keyframe_every")) filteredDoc["keyframe_every"] = config["keyframe_every"];
+    if (config.containsKey("batch_samples")) filteredDoc["batch_samples"] = config["batch_samples"];
+    if (config.containsKey("batch_seconds")) filteredDoc["batch_seconds"] = config["batch_seconds"];
 
 
     String filteredJson;
@@ -370,17 +409,99 @@ void FleetManager::handleFleetDeepScan(JsonDocument& payload, String commandId)
         "{\"msg\":\"Deep scan initiated\"}", commandId);
     
     int duration = payload["duration"] | 5;
-    String target = payload["target"] | "8.8.8.8";
+    String target = payload.containsKey("target") ? payload["target"].as<String>()
+                                                  : ConfigManager::getProbeTargets();
+
+    if (!MeasurementTask::acquireRadio(RADIO_COMMAND_WAIT_MS, MqttManager::keepAlive)) {
+        MqttManager::publishCommandResult("fleet_deep_scan", "failed",
+            "{\"error\":\"Radio busy with measurement cycle\"}", commandId);
+        return;
+    }
     
-    EnhancedMetrics em = DiagnosticEngine::performDeepAnalysis(target.c_str());
+    bool sweep = payload["sweep"] | false;
+    bool path = payload["path"] | false;
+    EnhancedMetrics em = DiagnosticEngine::performDeepAnalysis(target.c_str(), sweep, path);
+    MeasurementTask::releaseRadio();
+    // Only an off-channel sweep leaves the AP; the cached BSSID/channel
+    // usually gets us back before the result is published
+    ConnectionManager::reconnect();
+
     String probeId = String(ConfigManager::getProbeId());
     String resultPayload = JsonPackager::serializeEnhanced(em, probeId);
     
     MqttManager::publishCommandResult("fleet_deep_scan", "completed", 
         resultPayload, commandId);
-    
-    WifiCredentials creds = StorageManager::loadWifiCredentials();
-    WiFi.begin(creds.ssid.c_str(), creds.password.c_str());
+}
+
+/**
+ * Utilization map over channels 1-13. The dwell schedule comes from the
+ * payload: "dwell" as 13 per-channel values (0 skips a channel), or
+ * "dwell_ms" / "primary_dwell_ms" for the 1/6/11 split.
+ */
+void FleetManager::handleFleetChannelSweep(JsonDocument& payload, String commandId) {
+    MqttManager::publishCommandResult("fleet_channel_sweep", "processing",
+        "{\"msg\":\"Channel sweep initiated\"}", commandId);
+
+    SweepSchedule sched = SnifferEngine::defaultSchedule(
+        constrain(payload["dwell_ms"] | SWEEP_DEFAULT_DWELL_MS, 50, 2000),
+        constrain(payload["primary_dwell_ms"] | SWEEP_PRIMARY_DWELL_MS, 50, 2000));
+
+    if (payload["dwell"].is<JsonArray>()) {
+        JsonArray dwell = payload["dwell"].as<JsonArray>();
+        for (int i = 0; i < SWEEP_MAX_CHANNEL; i++) {
+            int ms = i < (int)dwell.size() ? dwell[i].as<int>() : 0;
+            sched.dwellMs[i] = ms > 0 ? constrain(ms, 50, 2000) : 0;
+        }
+    }
+
+    if (!MeasurementTask::acquireRadio(RADIO_COMMAND_WAIT_MS, MqttManager::keepAlive)) {
+        MqttManager::publishCommandResult("fleet_channel_sweep", "failed",
+            "{\"error\":\"Radio busy with measurement cycle\"}", commandId);
+        return;
+    }
+
+    ChannelSweep sweep = SnifferEngine::sweepChannels(sched);
+    MeasurementTask::releaseRadio();
+
+    ConnectionManager::reconnect();
+
+    String resultPayload = JsonPackager::serializeChannelSweep(sweep, ConfigManager::getProbeId());
+    MqttManager::publishCommandResult("fleet_channel_sweep", "completed",
+        resultPayload, commandId);
+}
+
+// TTL-stepped trace to "target", or to the first external probe target
+void FleetManager::handleFleetPathProbe(JsonDocument& payload, String commandId) {
+    MqttManager::publishCommandResult("fleet_path_probe", "processing",
+        "{\"msg\":\"Path probe initiated\"}", commandId);
+
+    String target = payload["target"] | "";
+    int maxHops = constrain(payload["max_hops"] | ConfigManager::load().pathMaxHops, 2, PATH_MAX_HOPS);
+
+    if (!MeasurementTask::acquireRadio(RADIO_COMMAND_WAIT_MS, MqttManager::keepAlive)) {
+        MqttManager::publishCommandResult("fleet_path_probe", "failed",
+            "{\"error\":\"Radio busy with measurement cycle\"}", commandId);
+        return;
+    }
+    PathResult path;
+    bool ok = DiagnosticEngine::tracePath(target.c_str(), maxHops, path);
+    MeasurementTask::releaseRadio();
+
+    if (!ok) {
+        MqttManager::publishCommandResult("fleet_path_probe", "failed",
+            "{\"error\":\"No hop answered\"}", commandId);
+        return;
+    }
+    String resultPayload = JsonPackager::serializePath(path, ConfigManager::getProbeId());
+    MqttManager::publishCommandResult("fleet_path_probe", "completed", resultPayload, commandId);
+}
+
+// A restarted backend has lost every delta chain at once
+void FleetManager::handleFleetResync(JsonDocument& payload, String commandId) {
+    DeltaEncoder::requestKeyframe();
+    MeasurementTask::requestCycle();
+    MqttManager::publishCommandResult("fleet_resync", "completed",
+        "{\"msg\":\"Keyframe scheduled\"}", commandId);
 }
 
 void FleetManager::handleFleetReboot(JsonDocument& payload, String commandId) {
@@ -412,7 +533,9 @@ void FleetManager::reportFleetStatus() {
     doc["probe_id"] = ConfigManager::getProbeId();
     doc["fw_version"] = ConfigManager::getFirmwareVersion();
     doc["uptime"] = millis() / 1000;
-    doc["timestamp"] = TimeManager::getTimestamp();
+    char timestamp[TIMESTAMP_LEN];
+    TimeManager::formatTimestamp(timestamp, sizeof(timestamp));
+    doc["timestamp"] = timestamp;
     doc["epoch"] = TimeManager::getEpoch();
     
     doc["managed"] = true;
@@ -440,10 +563,9 @@ void FleetManager::reportFleetStatus() {
     doc["mqtt_connected"] = MqttManager::isConnected();
     doc["free_heap"] = ESP.getFreeHeap();
     
-    String payload;
-    serializeJson(doc, payload);
-    
-    MqttManager::publishBroadcast("campus/fleet/status/" + String(ConfigManager::getProbeId()), payload);
+    char topic[MQTT_TOPIC_LEN];
+    snprintf(topic, sizeof(topic), "campus/fleet/status/%s", ConfigManager::getProbeId().c_str());
+    MqttManager::publishBroadcast(topic, doc);
 }
 
 bool FleetManager::isWithinMaintenanceWindow() {
@@ -36,6 +36,9 @@ private:
     static void handleFleetSchedule(JsonDocument& payload, String commandId);
     static void handleFleetOTA(JsonDocument& payload, String commandId);
     static void handleFleetDeepScan(JsonDocument& payload, String commandId);
+    static void handleFleetChannelSweep(JsonDocument& payload, String commandId);
+    static void handleFleetPathProbe(JsonDocument& payload, String commandId);
+    static void handleFleetResync(JsonDocument& payload, String commandId);
     static void handleFleetReboot(JsonDocument& payload, String commandId);
     static void handleFleetFactoryReset(JsonDocument& payload, String commandId);
     static void handleFleetCancel(JsonDocument& payload, String commandId);
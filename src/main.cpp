@@ -5,7 +5,11 @@
 #include "comms/MqttManager.h"
 #include "comms/CommandHandler.h"
 #include "diagnostics/DiagnosticEngine.h"
+#include "diagnostics/MeasurementTask.h"
 #include "packaging/JsonPackager.h"
+#include "packaging/TelemetryCodec.h"
+#include "packaging/DeltaEncoder.h"
+#include "packaging/TelemetryBatch.h"
 #include "packaging/TimeManager.h"
 #include "actions/led/StatusLED.h"
 #include "actions/button/ButtonManager.h"
@@ -15,6 +19,7 @@
 enum SystemState { PORTAL, RUNNING };
 SystemState currentState;
 SystemConfig activeCfg;
+TelemetryBatch telemetryBatch;
 
 const int LED_PIN = 2;
 const int BOOT_PIN = 0;
@@ -24,6 +29,11 @@ void startPortalMode();
 void startRunningMode();
 void handleRunningState();
 void performTelemetry();
+void publishMetrics(const NetworkMetrics& m);
+bool publishFrame(JsonDocument& doc);
+void publishBatch();
+void handleChangeEvents();
+void handleLinkRecords();
 
 void uiTask(void * pvParameters) {
     for(;;) {
@@ -66,6 +76,7 @@ void setupSystem() {
     
     StorageManager::begin();
     ConfigManager::begin();
+    ConnectionManager::begin();
     // Workaround to set version
     ConfigManager::setFirmwareVersion("v0.0.1");
     ConfigManager::setMaintenanceWindow("02:00-02:05");
@@ -88,7 +99,9 @@ void startRunningMode() {
 
     activeCfg = ConfigManager::load();
     
-    if (activeCfg.reportInterval > 1000) {
+    // A fixed interval that long is a misconfiguration; with adaptation on,
+    // report_interval is only the floor and interval_max_s bounds the stretch
+    if (!activeCfg.adaptiveInterval && activeCfg.reportInterval > 1000) {
         Serial.printf("[CONFIG] Fixing reportInterval from %d to 60\n", activeCfg.reportInterval);
         activeCfg.reportInterval = 60;
         ConfigManager::save(activeCfg);
@@ -103,13 +116,20 @@ void startRunningMode() {
     BroadcastManager::begin(&activeCfg);
     
     FleetManager::begin();
+
+    DeltaEncoder::configure(activeCfg.telemetryDelta, activeCfg.keyframeEvery);
+    if (activeCfg.batchSamples > 1 && !telemetryBatch.begin()) {
+        activeCfg.batchSamples = 1;
+    }
+    MeasurementTask::begin(&activeCfg);
     
     StatusLED::setStatus(STATUS_OK);
     currentState = RUNNING;
 }
 
 void handleRunningState() {
-    if (!ConnectionManager::isConnected()) {
+    LinkMonitor::poll();
+    if (LinkMonitor::linkDown()) {
         StatusLED::setStatus(ERR_WIFI);
         Serial.println("[SYSTEM] WiFi Lost. Reconnecting...");
         WifiCredentials creds = StorageManager::loadWifiCredentials();
@@ -129,32 +149,140 @@ void handleRunningState() {
     }
 
     if (MqttManager::hasPendingCommand()) {
+        // Cleared first: a long command keeps MQTT alive and may receive the next one
         PendingCommand cmd = MqttManager::getNextCommand();
-        CommandHandler::process(cmd);
         MqttManager::clearCommand();
+        CommandHandler::process(cmd);
     }
-    
-    static unsigned long lastReport = millis();
-    unsigned long elapsed = millis() - lastReport;
-    unsigned long interval = activeCfg.reportInterval * 1000;
-    
-    if (elapsed > interval) {
-        lastReport = millis();
-        performTelemetry();
+
+    if (MqttManager::hasPendingFleetCommand()) {
+        PendingCommand cmd = MqttManager::getNextFleetCommand();
+        DynamicJsonDocument payload(1024);
+        deserializeJson(payload, cmd.payload);
+        FleetManager::processFleetCommand(cmd.type, payload, cmd.id);
+        MqttManager::clearFleetCommand();
+    }
+
+    PendingCommand dropped;
+    if (MqttManager::takeDroppedFleetCommand(dropped)) {
+        MqttManager::publishCommandResult(dropped.type, "failed", "{\"error\": \"Fleet command queue full\"}", dropped.id);
     }
     
+    performTelemetry();
+    handleChangeEvents();
+    handleLinkRecords();
+    
     delay(100);
 }
 
+// Publishes whatever the measurement task has finished; never blocks on a measurement
 void performTelemetry() {
-    Serial.println("\n[DIAG] Telemetry Cycle");
-    NetworkMetrics m = DiagnosticEngine::performFullTest("8.8.8.8");
-    
-    String payload = JsonPackager::serializeLight(m, activeCfg.probe_id);
-    
-    if (MqttManager::publishTelemetry(payload)) {
+    NetworkMetrics m;
+    while (MeasurementTask::nextResult(m)) {
+        publishMetrics(m);
+    }
+
+    // A batch also goes out once its oldest sample is batchSeconds old
+    if (telemetryBatch.count() > 0 &&
+        telemetryBatch.ageMs() >= (unsigned long)activeCfg.batchSeconds * 1000UL) {
+        publishBatch();
+    }
+}
+
+// Hot path: one document allocated for the life of the program, streamed to the socket
+void publishMetrics(const NetworkMetrics& m) {
+    static DynamicJsonDocument doc(4096);
+    doc.clear();
+    JsonPackager::buildLight(doc, m, activeCfg.probe_id);
+
+    // Batches are columnar already; delta frames apply to single samples only
+    if (activeCfg.batchSamples > 1) {
+        // A rejected sample goes into a fresh batch, or alone if even that cannot hold it
+        if (!telemetryBatch.add(doc.as<JsonObjectConst>())) {
+            publishBatch();
+            if (!telemetryBatch.add(doc.as<JsonObjectConst>())) {
+                publishFrame(doc);
+                return;
+            }
+        }
+        if (telemetryBatch.count() >= activeCfg.batchSamples || telemetryBatch.full()) {
+            publishBatch();
+        }
+        return;
+    }
+
+    DeltaEncoder::encode(doc);
+    if (publishFrame(doc)) DeltaEncoder::commit();
+}
+
+void publishBatch() {
+    int n = telemetryBatch.count();
+    if (n == 0) return;
+    if (publishFrame(telemetryBatch.doc())) {
+        Serial.printf("[MQTT]  Batch of %d samples\n", n);
+    }
+    telemetryBatch.reset();
+}
+
+/**
+ * Publishes one document in the configured encoding(s); true once any
+ * encoding is out or buffered. Both topics share one delta seq, so a frame
+ * that reached either one must be committed: a topic that missed it sees a
+ * seq hole and asks for a keyframe, which is safe, whereas reusing the seq
+ * would hand it a delta against a baseline it never saw. Frames buffered
+ * offline replay on the JSON topic only, which leaves such a hole in the
+ * msgpack chain.
+ */
+bool publishFrame(JsonDocument& doc) {
+    bool packedSent = false;
+    if (activeCfg.telemetryEncoding != TELEMETRY_JSON) {
+        static uint8_t packed[TELEMETRY_PACK_MAX];
+        size_t len = TelemetryCodec::pack(doc.as<JsonVariantConst>(), packed, sizeof(packed));
+        packedSent = len > 0 && MqttManager::publishTelemetryPacked(packed, len);
+        if (packedSent) Serial.printf("[MQTT]  Telemetry published (msgpack, %u bytes)\n", (unsigned)len);
+    }
+    // JSON also covers the offline buffer, which only holds text
+    if (activeCfg.telemetryEncoding == TELEMETRY_MSGPACK && packedSent) return true;
+
+    bool buffered;
+    bool ok = MqttManager::publishTelemetry(doc, buffered);
+    if (ok && buffered) {
+        Serial.println("[MQTT]  Telemetry buffered offline");
+    } else if (ok) {
         Serial.println("[MQTT]  Telemetry published");
     } else {
-        Serial.println("[MQTT]  Telemetry buffered offline");
+        Serial.println("[MQTT]  Telemetry publish failed");
     }
-}
\ No newline at end of file
+    return ok || packedSent;
+}
+// Out-of-band events from the change detectors, plus any deep scan they queued
+void handleChangeEvents() {
+    ChangeEvent ev;
+    while (DiagnosticEngine::nextEvent(ev)) {
+        String payload = JsonPackager::serializeEvent(ev, activeCfg.probe_id);
+        if (MqttManager::publishEvent(payload)) {
+            Serial.println("[MQTT]  Event published");
+        }
+    }
+
+    uint8_t metric;
+    if (DiagnosticEngine::takeAutoScanRequest(metric)) {
+        PendingCommand cmd;
+        cmd.type = "deep_scan";
+        cmd.payload = "{}";
+        cmd.id = String("auto-") + changeMetricName(metric);
+        cmd.active = true;
+        Serial.printf("[SYSTEM] Automatic deep scan after %s change\n", changeMetricName(metric));
+        CommandHandler::process(cmd);
+    }
+}
+
+// Roam/reassociation episodes; kept queued until the broker takes them
+void handleLinkRecords() {
+    LinkRecord r;
+    while (LinkMonitor::peekRecord(r)) {
+        String payload = JsonPackager::serializeLinkRecord(r, activeCfg.probe_id);
+        if (!MqttManager::publishEvent(payload)) break;
+        LinkMonitor::popRecord();
+    }
+}
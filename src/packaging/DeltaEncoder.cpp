@@ -0,0 +1,90 @@
+#include "DeltaEncoder.h"
+
+bool DeltaEncoder::active = false;
+int DeltaEncoder::keyframeInterval = 10;
+DynamicJsonDocument* DeltaEncoder::baseline = nullptr;
+DynamicJsonDocument* DeltaEncoder::pending = nullptr;
+bool DeltaEncoder::haveBaseline = false;
+bool DeltaEncoder::keyframeRequested = false;
+bool DeltaEncoder::pendingKeyframe = false;
+uint32_t DeltaEncoder::seq = 0;
+int DeltaEncoder::sinceKeyframe = 0;
+
+void DeltaEncoder::configure(bool enabled, int keyframeEvery) {
+    active = enabled;
+    keyframeInterval = keyframeEvery < 1 ? 1 : keyframeEvery;
+    if (!active || baseline != nullptr) return;
+
+    baseline = new DynamicJsonDocument(DELTA_DOC_SIZE);
+    pending = new DynamicJsonDocument(DELTA_DOC_SIZE);
+    if (baseline->capacity() == 0 || pending->capacity() == 0) {
+        Serial.println("[DELTA] ✗ No memory for baselines, sending full frames");
+        active = false;
+    }
+}
+
+// Present in every frame, so never part of the diff
+bool DeltaEncoder::isHeaderKey(const char* key) {
+    return strcmp(key, "pid") == 0 || strcmp(key, "type") == 0 ||
+           strcmp(key, "ts") == 0 || strcmp(key, "epoch") == 0;
+}
+
+void DeltaEncoder::encode(JsonDocument& doc) {
+    if (!active) return;
+
+    *pending = doc;
+    uint32_t frameSeq = seq + 1;
+    pendingKeyframe = !haveBaseline || keyframeRequested || sinceKeyframe + 1 >= keyframeInterval;
+
+    if (pendingKeyframe) {
+        doc["seq"] = frameSeq;
+        doc["kf"] = true;
+        return;
+    }
+
+    JsonObjectConst full = pending->as<JsonObjectConst>();
+    JsonObjectConst prev = baseline->as<JsonObjectConst>();
+
+    doc.clear();
+    doc["pid"] = full["pid"];
+    doc["type"] = "light_delta";
+    doc["ts"] = full["ts"];
+    doc["epoch"] = full["epoch"];
+    doc["seq"] = frameSeq;
+
+    for (JsonPairConst kv : full) {
+        const char* key = kv.key().c_str();
+        if (isHeaderKey(key)) continue;
+        if (prev[key] != kv.value()) doc[kv.key()] = kv.value();
+    }
+
+    JsonArray removed;
+    for (JsonPairConst kv : prev) {
+        const char* key = kv.key().c_str();
+        if (isHeaderKey(key) || full.containsKey(key)) continue;
+        if (removed.isNull()) removed = doc.createNestedArray("del");
+        removed.add(kv.key());
+    }
+}
+
+void DeltaEncoder::commit() {
+    if (!active) return;
+
+    // Swap rather than copy; the old baseline is overwritten by the next encode()
+    DynamicJsonDocument* t = baseline;
+    baseline = pending;
+    pending = t;
+    haveBaseline = true;
+    seq++;
+
+    if (pendingKeyframe) {
+        keyframeRequested = false;
+        sinceKeyframe = 0;
+    } else {
+        sinceKeyframe++;
+    }
+}
+
+void DeltaEncoder::requestKeyframe() {
+    keyframeRequested = true;
+}
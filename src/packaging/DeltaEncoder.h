@@ -0,0 +1,43 @@
+#ifndef DELTA_ENCODER_H
+#define DELTA_ENCODER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define DELTA_DOC_SIZE 4096
+
+/**
+ * Light telemetry as keyframes and deltas. A keyframe is the full light
+ * document plus "seq" and "kf": true. In between, "light_delta" frames
+ * carry pid/type/ts/epoch/seq, only the top-level fields whose value
+ * changed since the previous frame (arrays and objects compare whole), and
+ * "del" listing fields that disappeared. The baseline moves only when a
+ * frame is committed (published or buffered), so seq has no holes of its
+ * own making; a backend that sees one asks for a keyframe ("resync").
+ */
+class DeltaEncoder {
+public:
+    static void configure(bool enabled, int keyframeEvery);
+    static bool enabled() { return active; }
+
+    // Rewrites a full light document into this cycle's frame
+    static void encode(JsonDocument& doc);
+    // The frame from the last encode() went out; it becomes the baseline
+    static void commit();
+    static void requestKeyframe();
+
+private:
+    static bool isHeaderKey(const char* key);
+
+    static bool active;
+    static int keyframeInterval;
+    static DynamicJsonDocument* baseline;   // full document of the last committed frame
+    static DynamicJsonDocument* pending;    // full document of the frame being sent
+    static bool haveBaseline;
+    static bool keyframeRequested;
+    static bool pendingKeyframe;
+    static uint32_t seq;                    // of the last committed frame
+    static int sinceKeyframe;
+};
+
+#endif
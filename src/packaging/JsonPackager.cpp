@@ -2,49 +2,300 @@
 #include "../packaging/TimeManager.h"
 
 String JsonPackager::serializeLight(const NetworkMetrics& m, String probeId) {
-    StaticJsonDocument<384> doc;
-    
+    DynamicJsonDocument doc(4096);
+    buildLight(doc, m, probeId.c_str());
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+/**
+ * The caller may keep this document past the lifetime of m (the delta
+ * baseline does), so strings that live in m are cast to char* to make
+ * ArduinoJson copy them instead of storing the pointer. probeId is stored
+ * as a pointer and must outlive the document.
+ */
+void JsonPackager::buildLight(JsonDocument& doc, const NetworkMetrics& m, const char* probeId) {
+    char timestamp[TIMESTAMP_LEN];
+    TimeManager::formatTimestamp(timestamp, sizeof(timestamp));
+
     doc["pid"] = probeId;
     doc["type"] = "light";
-    doc["ts"] = TimeManager::getTimestamp();
+    doc["ts"] = timestamp;
     doc["epoch"] = TimeManager::getEpoch();
     doc["rssi"] = m.rssi;
     doc["lat"] = m.avgLatency;
+    doc["lat_min"] = m.minLatency;
+    doc["lat_max"] = m.maxLatency;
+    doc["lat_p50"] = m.p50Latency;
+    doc["lat_p95"] = m.p95Latency;
+    doc["jitter"] = m.jitter;
     doc["loss"] = m.packetLoss;
+    doc["lan_rtt"] = m.lanRtt;
+    doc["lan_loss"] = m.lanLoss;
+    doc["wan_rtt"] = m.wanRtt;
+    if (m.lanRtt >= 0 && m.wanRtt >= 0) doc["wan_delta"] = m.wanDelta;
     doc["dns"] = m.dnsResolutionTime;
     doc["ch"] = m.channel;
     doc["cong"] = (int)m.congestion;
-    doc["bssid"] = m.bssid;
+    doc["bssid"] = (char*)m.bssid;
     doc["neighbors"] = m.neighborCount;
     doc["overlap"] = m.overlappingCount;
-    
-    String output;
-    serializeJson(doc, output);
-    return output;
+    if (m.noiseFloor != 0) {
+        doc["noise"] = m.noiseFloor;
+        doc["snr"] = m.snr;
+    }
+    doc["reconn"] = m.reconnectMs;
+    doc["reconn_n"] = m.reconnectCount;
+    doc["reconn_fast"] = m.reconnectFast;
+    doc["roams"] = m.roamCount;
+    doc["ivl"] = m.intervalS;
+    doc["ivl_reason"] = IntervalController::reasonName((IntervalReason)m.intervalReason);
+    doc["cyc_ms"] = m.cycleMs;
+    if (m.deferredMask != 0) {
+        JsonArray deferred = doc.createNestedArray("deferred");
+        for (int i = 0; i < CycleScheduler::count(); i++) {
+            if (m.deferredMask & (1 << i)) deferred.add(CycleScheduler::name(i));
+        }
+    }
+
+    // Between-cycle samples; omitted when the sampler had no chance to run
+    if (m.rssiSamples.count > 0) {
+        addSummary(doc, "rssi_s", m.rssiSamples);
+    }
+    if (m.gwProbesSent > 0) {
+        JsonObject gw = addSummary(doc, "gw_s", m.gwRttSamples);
+        gw["sent"] = m.gwProbesSent;
+        gw["lost"] = m.gwProbesLost;
+    }
+
+    JsonArray targets = doc.createNestedArray("targets");
+    for (int i = 0; i < m.targetCount; i++) {
+        const LatencyStats& s = m.targets[i].stats;
+        JsonObject t = targets.createNestedObject();
+        t["t"] = (char*)m.targets[i].label;
+        t["lat"] = s.avgMs;
+        t["p95"] = s.p95Ms;
+        t["jit"] = s.jitterMs;
+        t["loss"] = s.lossPct;
+    }
+
+    JsonArray resolvers = doc.createNestedArray("resolvers");
+    for (int i = 0; i < m.resolverCount; i++) {
+        const ResolverStats& s = m.resolvers[i].stats;
+        JsonObject r = resolvers.createNestedObject();
+        r["r"] = (char*)m.resolvers[i].label;
+        r["n"] = s.sent;
+        r["p50"] = s.latency.p50Ms;
+        r["p95"] = s.latency.p95Ms;
+        r["to"] = s.timeouts;
+        r["sf"] = s.servfail;
+    }
+
+    if (m.pathFresh) addPath(doc, m.path);
+
+    // Per-URL phase breakdown, ms; -1 marks a phase that was not reached
+    if (m.httpCount > 0) {
+        JsonArray http = doc.createNestedArray("http");
+        for (int i = 0; i < m.httpCount; i++) {
+            const HttpTiming& t = m.http[i].timing;
+            JsonObject h = http.createNestedObject();
+            h["u"] = (char*)m.http[i].label;
+            h["st"] = t.status;
+            if (t.failedPhase != HTTP_PHASE_NONE) h["fail"] = t.failedPhase;
+            h["dns"] = t.dnsMs;
+            h["tcp"] = t.connectMs;
+            h["tls"] = t.tlsMs;
+            h["ttfb"] = t.ttfbMs;
+            h["xfer"] = t.transferMs;
+            h["tot"] = t.totalMs;
+            h["b"] = t.bytes;
+        }
+    }
 }
 
 String JsonPackager::serializeEnhanced(const EnhancedMetrics& em, String probeId) {
-    StaticJsonDocument<640> doc;
+    DynamicJsonDocument doc(4096);
     
     doc["pid"] = probeId;
     doc["type"] = "enhanced";
     doc["ts"] = TimeManager::getTimestamp();
     doc["epoch"] = TimeManager::getEpoch();
     doc["rssi"] = em.rssi;
-    doc["snr"] = em.snr;
     doc["qual"] = em.linkQuality;
     doc["util"] = em.channelUtilization;
+    doc["util_mgmt"] = em.mgmtUtilization;
+    doc["util_ctrl"] = em.ctrlUtilization;
+    doc["util_data"] = em.dataUtilization;
     doc["phy"] = em.phyMode;
     doc["tput"] = em.tcpThroughput;
+    doc["tput_up"] = em.uploadThroughput;
     doc["up"] = em.uptime;
+    doc["link_kept"] = em.linkKept;
     doc["bssid"] = em.bssid;
     doc["ch"] = em.channel;
-    doc["noise"] = em.noiseFloor;
+    if (em.noiseFloor != 0) {
+        doc["noise"] = em.noiseFloor;
+        doc["snr"] = em.snr;
+    }
     doc["lat"] = em.avgLatency;
+    doc["lat_p95"] = em.p95Latency;
+    doc["jitter"] = em.jitter;
     doc["loss"] = em.packetLoss;
+    doc["lan_rtt"] = em.lanRtt;
+    doc["wan_rtt"] = em.wanRtt;
     doc["dns"] = em.dnsResolutionTime;
+    doc["bcn_loss"] = em.ownBeaconLoss;
+    doc["bcn_loss_nbr"] = em.neighborBeaconLoss;
+
+    JsonArray aps = doc.createNestedArray("aps");
+    for (int i = 0; i < em.beaconApCount; i++) {
+        const ApBeaconStats& ap = em.beaconAps[i];
+        char bssid[18];
+        formatBssid(ap.bssid, bssid);
+        JsonObject a = aps.createNestedObject();
+        a["b"] = bssid;
+        a["rssi"] = ap.rssi;
+        a["loss"] = ap.lossPct;
+    }
+    if (em.sweep.count > 0) addChannelMap(doc, em.sweep);
+    if (em.pathFresh) addPath(doc, em.path);
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+String JsonPackager::serializeChannelSweep(const ChannelSweep& sweep, String probeId) {
+    DynamicJsonDocument doc(2048);
+
+    doc["pid"] = probeId;
+    doc["type"] = "chmap";
+    doc["ts"] = TimeManager::getTimestamp();
+    doc["epoch"] = TimeManager::getEpoch();
+    addChannelMap(doc, sweep);
 
     String output;
     serializeJson(doc, output);
     return output;
-}
\ No newline at end of file
+}
+
+String JsonPackager::serializeEvent(const ChangeEvent& ev, String probeId) {
+    StaticJsonDocument<384> doc;
+
+    doc["pid"] = probeId;
+    doc["type"] = "event";
+    doc["ts"] = TimeManager::getTimestamp();
+    doc["epoch"] = TimeManager::getEpoch();
+    doc["metric"] = changeMetricName(ev.metric);
+    doc["dir"] = ev.direction > 0 ? "up" : "down";
+    doc["degraded"] = ev.degraded;
+    doc["value"] = ev.value;
+    doc["baseline"] = ev.baseline;
+    doc["sigma"] = ev.sigma;
+    doc["deep_scan"] = ev.deepScan;
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+String JsonPackager::serializeLinkRecord(const LinkRecord& r, String probeId) {
+    StaticJsonDocument<512> doc;
+    char oldBssid[18], newBssid[18];
+    formatBssid(r.oldBssid, oldBssid);
+    formatBssid(r.newBssid, newBssid);
+
+    doc["pid"] = probeId;
+    doc["type"] = r.roamed ? "roam" : "reassoc";
+    doc["ts"] = TimeManager::getTimestamp();
+    doc["epoch"] = TimeManager::getEpoch();
+    doc["ago_ms"] = millis() - r.atMs;
+    doc["reason"] = r.reason;
+    doc["old"] = oldBssid;
+    doc["new"] = newBssid;
+    doc["ch"] = r.channel;
+    doc["rssi_before"] = r.rssiBefore;
+    doc["rssi_after"] = r.rssiAfter;
+    doc["assoc_ms"] = r.assocMs;
+    doc["dhcp_ms"] = r.dhcpMs;
+    doc["total_ms"] = r.totalMs;
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+String JsonPackager::serializePath(const PathResult& path, String probeId) {
+    DynamicJsonDocument doc(1536);
+
+    doc["pid"] = probeId;
+    doc["type"] = "path";
+    doc["ts"] = TimeManager::getTimestamp();
+    doc["epoch"] = TimeManager::getEpoch();
+    addPath(doc, path);
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+// One compact row per channel: [ch, util %, APs, beacon loss %, dwell ms]
+void JsonPackager::addChannelMap(JsonDocument& doc, const ChannelSweep& sweep) {
+    JsonArray map = doc.createNestedArray("chmap");
+    for (int i = 0; i < sweep.count; i++) {
+        const ChannelUsage& u = sweep.channels[i];
+        JsonArray row = map.createNestedArray();
+        row.add(u.channel);
+        row.add(u.utilization);
+        row.add(u.apCount);
+        row.add(u.beaconLossPct);
+        row.add(u.dwellMs);
+    }
+}
+JsonObject JsonPackager::addSummary(JsonDocument& doc, const char* key, const SampleSummary& s) {
+    JsonObject o = doc.createNestedObject(key);
+    o["n"] = s.count;
+    if (s.count > 0) {
+        o["min"] = s.min;
+        o["mean"] = s.mean;
+        o["p50"] = s.p50;
+        o["p95"] = s.p95;
+        o["max"] = s.max;
+    }
+    return o;
+}
+
+// out must hold 18 bytes
+void JsonPackager::formatBssid(const uint8_t* bssid, char* out) {
+    snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
+             bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5]);
+}
+
+// Network byte order, as lwIP keeps addresses
+void JsonPackager::formatIp(uint32_t ip, char* out) {
+    const uint8_t* b = (const uint8_t*)&ip;
+    snprintf(out, 16, "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+}
+
+// "path": {"t", "reached", "hops": [[ip, rtt ms], ...]}, "*" and -1 for silent hops
+void JsonPackager::addPath(JsonDocument& doc, const PathResult& path) {
+    char ipText[16];
+    JsonObject p = doc.createNestedObject("path");
+    formatIp(path.target, ipText);
+    p["t"] = ipText;
+    p["reached"] = path.reached;
+    JsonArray hops = p.createNestedArray("hops");
+    for (int i = 0; i < path.hopCount; i++) {
+        const PathHop& h = path.hops[i];
+        JsonArray row = hops.createNestedArray();
+        if (h.replies > 0) {
+            formatIp(h.ip, ipText);
+            row.add(ipText);
+        } else {
+            row.add("*");
+        }
+        row.add(h.rttMs);
+    }
+}
@@ -4,11 +4,28 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "../diagnostics/DiagnosticEngine.h"
+#include "../diagnostics/IntervalController.h"
+#include "../diagnostics/CycleScheduler.h"
+#include "../connection/LinkMonitor.h"
 
 class JsonPackager {
 public:
     static String serializeLight(const NetworkMetrics& m, String probeId);
+    // The light document itself, for callers that re-encode it (delta, MessagePack)
+    // Allocation-free: every string is either static or copied into the document's pool
+    static void buildLight(JsonDocument& doc, const NetworkMetrics& m, const char* probeId);
     static String serializeEnhanced(const EnhancedMetrics& em, String probeId);
+    static String serializeChannelSweep(const ChannelSweep& sweep, String probeId);
+    static String serializeEvent(const ChangeEvent& ev, String probeId);
+    static String serializeLinkRecord(const LinkRecord& r, String probeId);
+    static String serializePath(const PathResult& path, String probeId);
+
+private:
+    static void addChannelMap(JsonDocument& doc, const ChannelSweep& sweep);
+    static void formatBssid(const uint8_t* bssid, char* out);
+    static void formatIp(uint32_t ip, char* out);
+    static void addPath(JsonDocument& doc, const PathResult& path);
+    static JsonObject addSummary(JsonDocument& doc, const char* key, const SampleSummary& s);
 };
 
 #endif
\ No newline at end of file
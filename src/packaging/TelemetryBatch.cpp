@@ -0,0 +1,120 @@
+#include "TelemetryBatch.h"
+
+TelemetryBatch::TelemetryBatch() : root(nullptr), n(0), firstAt(0), t0(0) {}
+
+TelemetryBatch::~TelemetryBatch() {
+    delete root;
+}
+
+bool TelemetryBatch::begin(size_t capacity) {
+    if (root == nullptr) root = new DynamicJsonDocument(capacity);
+    if (root->capacity() == 0) {
+        Serial.println("[BATCH] ✗ No memory for the batch document");
+        return false;
+    }
+    reset();
+    return true;
+}
+
+bool TelemetryBatch::isHeaderKey(const char* key) {
+    return strcmp(key, "pid") == 0 || strcmp(key, "type") == 0 ||
+           strcmp(key, "ts") == 0 || strcmp(key, "epoch") == 0;
+}
+
+/**
+ * Deep copy that duplicates every string. A plain variant copy keeps
+ * const char* values as pointers, which would dangle once the sample's
+ * source (a NetworkMetrics, a reused parse document) is gone.
+ */
+void TelemetryBatch::copyOwned(JsonVariant dst, JsonVariantConst src) {
+    if (src.is<JsonObjectConst>()) {
+        JsonObject obj = dst.to<JsonObject>();
+        for (JsonPairConst kv : src.as<JsonObjectConst>()) {
+            copyOwned(obj.getOrAddMember((char*)kv.key().c_str()), kv.value());
+        }
+    } else if (src.is<JsonArrayConst>()) {
+        JsonArray arr = dst.to<JsonArray>();
+        for (JsonVariantConst v : src.as<JsonArrayConst>()) {
+            copyOwned(arr.addElement(), v);
+        }
+    } else if (src.is<const char*>()) {
+        dst.set((char*)src.as<const char*>());
+    } else {
+        dst.set(src);
+    }
+}
+
+bool TelemetryBatch::add(JsonObjectConst sample) {
+    JsonDocument& d = *root;
+    if (n == 0) {
+        firstAt = millis();
+        t0 = sample["epoch"] | 0L;
+        d["pid"] = (char*)(sample["pid"] | "");
+        d["type"] = "batch";
+        d["t0"] = t0;
+        d.createNestedArray("dt");
+        d.createNestedObject("cols");
+    }
+    JsonObject cols = d["cols"];
+    size_t columnsBefore = cols.size();
+    d["dt"].add((sample["epoch"] | 0L) - t0);
+
+    // JsonString keys keep their ownership, so keys parsed from text are copied
+    for (JsonPairConst kv : sample) {
+        if (isHeaderKey(kv.key().c_str())) continue;
+        JsonArray col = cols[kv.key()];
+        if (col.isNull()) {
+            col = cols.createNestedArray(kv.key());
+            for (int i = 0; i < n; i++) col.add();
+        }
+        copyOwned(col.addElement(), kv.value());
+    }
+    for (JsonPair kv : cols) {
+        JsonArray col = kv.value();
+        for (int i = col.size(); i < n + 1; i++) col.add();
+    }
+
+    // A full pool drops writes silently; take the whole row back out
+    if (d.overflowed() || measureJson(d) > BATCH_MAX_BYTES) {
+        truncate(columnsBefore);
+        if (n == 0) reset();
+        return false;
+    }
+
+    n++;
+    d["n"] = n;
+    return true;
+}
+
+// Back to n rows and the first `columns` columns
+void TelemetryBatch::truncate(size_t columns) {
+    JsonDocument& d = *root;
+    JsonArray dt = d["dt"];
+    while ((int)dt.size() > n) dt.remove(dt.size() - 1);
+
+    JsonObject cols = d["cols"];
+    while (cols.size() > columns) {
+        JsonObject::iterator last = cols.begin();
+        for (JsonObject::iterator it = cols.begin(); it != cols.end(); ++it) last = it;
+        cols.remove(last);
+    }
+    for (JsonPair kv : cols) {
+        JsonArray col = kv.value();
+        while ((int)col.size() > n) col.remove(col.size() - 1);
+    }
+}
+
+bool TelemetryBatch::full() const {
+    if (n == 0) return false;
+    if (n >= BATCH_MAX_SAMPLES) return true;
+    size_t bytes = measureJson(*root);
+    size_t used = root->memoryUsage();
+    return bytes + bytes / n > BATCH_MAX_BYTES || used + used / n > root->capacity();
+}
+
+void TelemetryBatch::reset() {
+    if (root) root->clear();
+    n = 0;
+    firstAt = 0;
+    t0 = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define BATCH_DOC_SIZE 12288
+#define BATCH_MAX_BYTES 3840        // serialized; stays inside the MQTT client buffer
+#define BATCH_MAX_SAMPLES 30
+
+/**
+ * Light samples folded into one columnar document:
+ *   {"pid", "type": "batch", "n", "t0": first epoch, "dt": [s offsets],
+ *    "cols": {"rssi": [...], "lat": [...], "targets": [[...], ...], ...}}
+ * Every column has n entries, null where a sample lacked the field; nested
+ * values (targets, http, path) are kept whole per sample. ts is dropped,
+ * epoch becomes t0 + dt. Strings are copied into the batch, so a sample's
+ * document can be reused as soon as add() returns.
+ */
+class TelemetryBatch {
+public:
+    TelemetryBatch();
+    ~TelemetryBatch();
+
+    bool begin(size_t capacity = BATCH_DOC_SIZE);
+    // False if the sample would overflow the document or BATCH_MAX_BYTES; the
+    // batch is then left as it was, to be flushed before adding it again
+    bool add(JsonObjectConst sample);
+    void reset();
+
+    int count() const { return n; }
+    unsigned long ageMs() const { return n > 0 ? millis() - firstAt : 0; }
+    // Another sample like the ones so far would likely not fit; add() has the final say
+    bool full() const;
+    JsonDocument& doc() { return *root; }
+
+private:
+    static bool isHeaderKey(const char* key);
+    static void copyOwned(JsonVariant dst, JsonVariantConst src);
+    void truncate(size_t columns);
+
+    DynamicJsonDocument* root;
+    int n;
+    unsigned long firstAt;
+    long t0;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "TelemetryCodec.h"
+
+// Index = field ID. Append only; never reorder, reuse or remove an entry.
+static const char* const FIELD_KEYS[] = {
+    "",             //  0 schema version (TELEMETRY_SCHEMA_KEY)
+    "pid",          //  1
+    "type",         //  2
+    "ts",           //  3
+    "epoch",        //  4
+    "rssi",         //  5
+    "lat",          //  6
+    "lat_min",      //  7
+    "lat_max",      //  8
+    "lat_p50",      //  9
+    "lat_p95",      // 10
+    "jitter",       // 11
+    "loss",         // 12
+    "lan_rtt",      // 13
+    "lan_loss",     // 14
+    "wan_rtt",      // 15
+    "wan_delta",    // 16
+    "dns",          // 17
+    "ch",           // 18
+    "cong",         // 19
+    "bssid",        // 20
+    "neighbors",    // 21
+    "overlap",      // 22
+    "noise",        // 23
+    "snr",          // 24
+    "reconn",       // 25
+    "reconn_n",     // 26
+    "reconn_fast",  // 27
+    "roams",        // 28
+    "ivl",          // 29
+    "ivl_reason",   // 30
+    "cyc_ms",       // 31
+    "deferred",     // 32
+    "rssi_s",       // 33
+    "gw_s",         // 34
+    "sent",         // 35
+    "lost",         // 36
+    "n",            // 37
+    "min",          // 38
+    "mean",         // 39
+    "p50",          // 40
+    "p95",          // 41
+    "max",          // 42
+    "targets",      // 43
+    "t",            // 44
+    "jit",          // 45
+    "resolvers",    // 46
+    "r",            // 47
+    "to",           // 48
+    "sf",           // 49
+    "path",         // 50
+    "reached",      // 51
+    "hops",         // 52
+    "http",         // 53
+    "u",            // 54
+    "st",           // 55
+    "fail",         // 56
+    "tcp",          // 57
+    "tls",          // 58
+    "ttfb",         // 59
+    "xfer",         // 60
+    "tot",          // 61
+    "b",            // 62
+    "seq",          // 63
+    "kf",           // 64
+    "del",          // 65
+    "t0",           // 66
+    "dt",           // 67
+    "cols"          // 68
+};
+static const int FIELD_COUNT = sizeof(FIELD_KEYS) / sizeof(FIELD_KEYS[0]);
+
+uint8_t* TelemetryCodec::buf = nullptr;
+size_t TelemetryCodec::capacity = 0;
+size_t TelemetryCodec::len = 0;
+bool TelemetryCodec::overflow = false;
+
+int TelemetryCodec::keyId(const char* key) {
+    for (int i = 1; i < FIELD_COUNT; i++) {
+        if (strcmp(FIELD_KEYS[i], key) == 0) return i;
+    }
+    return -1;
+}
+
+size_t TelemetryCodec::pack(JsonVariantConst root, uint8_t* out, size_t cap) {
+    buf = out;
+    capacity = cap;
+    len = 0;
+    overflow = false;
+
+    if (root.is<JsonObjectConst>()) {
+        // Same map as the JSON, with the schema version in front
+        JsonObjectConst obj = root.as<JsonObjectConst>();
+        writeMapHeader(obj.size() + 1);
+        writeUint(TELEMETRY_SCHEMA_KEY);
+        writeUint(TELEMETRY_SCHEMA_VERSION);
+        for (JsonPairConst kv : obj) {
+            writeKey(kv.key().c_str());
+            writeValue(kv.value());
+        }
+    } else {
+        writeValue(root);
+    }
+    return overflow ? 0 : len;
+}
+
+void TelemetryCodec::writeValue(JsonVariantConst v) {
+    if (v.isNull()) {
+        put(0xc0);
+    } else if (v.is<bool>()) {
+        put(v.as<bool>() ? 0xc3 : 0xc2);
+    } else if (v.is<long>()) {
+        writeInt(v.as<long>());
+    } else if (v.is<unsigned long>()) {
+        writeUint(v.as<unsigned long>());
+    } else if (v.is<float>()) {
+        writeFloat(v.as<float>());
+    } else if (v.is<const char*>()) {
+        writeString(v.as<const char*>());
+    } else if (v.is<JsonObjectConst>()) {
+        JsonObjectConst obj = v.as<JsonObjectConst>();
+        writeMapHeader(obj.size());
+        for (JsonPairConst kv : obj) {
+            writeKey(kv.key().c_str());
+            writeValue(kv.value());
+        }
+    } else if (v.is<JsonArrayConst>()) {
+        JsonArrayConst arr = v.as<JsonArrayConst>();
+        writeArrayHeader(arr.size());
+        for (JsonVariantConst e : arr) {
+            writeValue(e);
+        }
+    } else {
+        put(0xc0);
+    }
+}
+
+void TelemetryCodec::writeKey(const char* key) {
+    int id = keyId(key);
+    if (id >= 0) {
+        writeUint(id);
+    } else {
+        writeString(key);
+    }
+}
+
+void TelemetryCodec::writeMapHeader(size_t n) {
+    if (n < 16) {
+        put(0x80 | n);
+    } else {
+        put(0xde);
+        putBig(n, 2);
+    }
+}
+
+void TelemetryCodec::writeArrayHeader(size_t n) {
+    if (n < 16) {
+        put(0x90 | n);
+    } else {
+        put(0xdc);
+        putBig(n, 2);
+    }
+}
+
+void TelemetryCodec::writeString(const char* s) {
+    size_t n = strlen(s);
+    if (n < 32) {
+        put(0xa0 | n);
+    } else if (n < 256) {
+        put(0xd9);
+        put(n);
+    } else {
+        put(0xda);
+        putBig(n, 2);
+    }
+    for (size_t i = 0; i < n; i++) put(s[i]);
+}
+
+void TelemetryCodec::writeInt(long v) {
+    if (v >= 0) {
+        writeUint((unsigned long)v);
+    } else if (v >= -32) {
+        put((uint8_t)(int8_t)v);
+    } else if (v >= -128) {
+        put(0xd0);
+        put((uint8_t)(int8_t)v);
+    } else if (v >= -32768) {
+        put(0xd1);
+        putBig((uint16_t)(int16_t)v, 2);
+    } else {
+        put(0xd2);
+        putBig((uint32_t)(int32_t)v, 4);
+    }
+}
+
+void TelemetryCodec::writeUint(unsigned long v) {
+    if (v < 128) {
+        put(v);
+    } else if (v < 256) {
+        put(0xcc);
+        put(v);
+    } else if (v < 65536) {
+        put(0xcd);
+        putBig(v, 2);
+    } else {
+        put(0xce);
+        putBig(v, 4);
+    }
+}
+
+void TelemetryCodec::writeFloat(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    put(0xca);
+    putBig(bits, 4);
+}
+
+void TelemetryCodec::put(uint8_t b) {
+    if (len >= capacity) {
+        overflow = true;
+        return;
+    }
+    buf[len++] = b;
+}
+
+void TelemetryCodec::putBig(uint32_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) put((uint8_t)(v >> (8 * i)));
+}
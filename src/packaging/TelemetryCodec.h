@@ -0,0 +1,44 @@
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define TELEMETRY_SCHEMA_VERSION 1
+#define TELEMETRY_SCHEMA_KEY 0      // field 0 of the top-level map carries the version
+#define TELEMETRY_PACK_MAX 3072
+
+/**
+ * MessagePack with numeric field IDs. Walks a finished JsonDocument and
+ * writes every known key as a small integer from the field table (one
+ * namespace, nested objects included); unknown keys go out as strings so
+ * a payload never loses a field the table has not caught up with.
+ * Floats are narrowed to float32. The table is append-only: an ID, once
+ * shipped, always means the same key. Not re-entrant.
+ */
+class TelemetryCodec {
+public:
+    // Bytes written, 0 if the encoding did not fit in cap
+    static size_t pack(JsonVariantConst root, uint8_t* out, size_t cap);
+    // Field ID of a key, -1 if it has none
+    static int keyId(const char* key);
+
+private:
+    static void writeValue(JsonVariantConst v);
+    static void writeKey(const char* key);
+    static void writeMapHeader(size_t n);
+    static void writeArrayHeader(size_t n);
+    static void writeString(const char* s);
+    static void writeInt(long v);
+    static void writeUint(unsigned long v);
+    static void writeFloat(float v);
+    static void put(uint8_t b);
+    static void putBig(uint32_t v, int bytes);
+
+    static uint8_t* buf;
+    static size_t capacity;
+    static size_t len;
+    static bool overflow;
+};
+
+#endif
@@ -38,10 +38,17 @@ uint32_t TimeManager::getEpoch() {
 }
 
 String TimeManager::getTimestamp() {
-    struct tm timeinfo;
-    if(!getLocalTime(&timeinfo)) return "1970-01-01 00:00:00";
-    
-    char buf[25];
-    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    char buf[TIMESTAMP_LEN];
+    formatTimestamp(buf, sizeof(buf));
     return String(buf);
+}
+
+void TimeManager::formatTimestamp(char* out, size_t len) {
+    struct tm timeinfo;
+    if (!getLocalTime(&timeinfo)) {
+        strncpy(out, "1970-01-01 00:00:00", len - 1);
+        out[len - 1] = '\0';
+        return;
+    }
+    strftime(out, len, "%Y-%m-%d %H:%M:%S", &timeinfo);
 }
\ No newline at end of file
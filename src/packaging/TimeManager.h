@@ -4,11 +4,14 @@
 #include <Arduino.h>
 #include <time.h>
 
+#define TIMESTAMP_LEN 20    // "YYYY-MM-DD HH:MM:SS" plus the terminator
+
 class TimeManager {
 public:
     static void begin();
     static void sync();
     static String getTimestamp(); // Returns ISO 8601 string or Unix epoch
+    static void formatTimestamp(char* out, size_t len);   // same text, caller's buffer
     static uint32_t getEpoch();
 };
 
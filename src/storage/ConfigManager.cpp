@@ -34,6 +34,12 @@ void ConfigManager::setProbeId(String newId) {
     if(newId.length() > 0) prefs.putString("probe_id", newId);
 }
 
+String ConfigManager::getProbeTargets() { return prefs.getString("probe_targets", DEFAULT_PROBE_TARGETS); }
+
+void ConfigManager::setProbeTargets(String targets) {
+    if(targets.length() > 0) prefs.putString("probe_targets", targets);
+}
+
 String ConfigManager::getSafeConfigJson() {
     DynamicJsonDocument doc(1024);
     
@@ -50,6 +56,7 @@ String ConfigManager::getSafeConfigJson() {
     doc["mqtt"]["broker"] = getMqttBroker();
     doc["mqtt"]["port"] = getMqttPort();
     doc["mqtt"]["user"] = getMqttUser();
+    doc["targets"] = getProbeTargets();
     doc["heap_free"] = ESP.getFreeHeap();
     doc["uptime"] = millis() / 1000;
     
@@ -81,6 +88,57 @@ SystemConfig ConfigManager::load() {
     config.cmdTopic[sizeof(config.cmdTopic) - 1] = '\0';
     
     config.reportInterval = prefs.getInt("report_interval", 60);    
+    config.pingCount = prefs.getInt("ping_count", 10);
+    config.pingIntervalMs = prefs.getInt("ping_interval", 200);
+
+    String targets = getProbeTargets();
+    strncpy(config.probeTargets, targets.c_str(), sizeof(config.probeTargets) - 1);
+    config.probeTargets[sizeof(config.probeTargets) - 1] = '\0';
+
+    String resolvers = prefs.getString("dns_resolvers", DEFAULT_DNS_RESOLVERS);
+    strncpy(config.dnsResolvers, resolvers.c_str(), sizeof(config.dnsResolvers) - 1);
+    config.dnsResolvers[sizeof(config.dnsResolvers) - 1] = '\0';
+
+    String zone = prefs.getString("dns_zone", DEFAULT_DNS_ZONE);
+    strncpy(config.dnsZone, zone.c_str(), sizeof(config.dnsZone) - 1);
+    config.dnsZone[sizeof(config.dnsZone) - 1] = '\0';
+
+    String names = prefs.getString("dns_names", "");
+    strncpy(config.dnsNames, names.c_str(), sizeof(config.dnsNames) - 1);
+    config.dnsNames[sizeof(config.dnsNames) - 1] = '\0';
+
+    config.dnsQueries = prefs.getInt("dns_queries", 5);
+
+    String tputUrl = prefs.getString("tput_url", DEFAULT_TPUT_URL);
+    strncpy(config.tputUrl, tputUrl.c_str(), sizeof(config.tputUrl) - 1);
+    config.tputUrl[sizeof(config.tputUrl) - 1] = '\0';
+
+    String tputUpUrl = prefs.getString("tput_up_url", "");
+    strncpy(config.tputUploadUrl, tputUpUrl.c_str(), sizeof(config.tputUploadUrl) - 1);
+    config.tputUploadUrl[sizeof(config.tputUploadUrl) - 1] = '\0';
+
+    config.tputDurationMs = prefs.getInt("tput_duration", 5000);
+    config.tputBytes = prefs.getInt("tput_bytes", 1048576);
+    config.sampleIntervalMs = prefs.getInt("sample_ms", 2000);
+    config.eventDetect = prefs.getBool("evt_detect", true);
+    config.autoDeepScan = prefs.getBool("auto_scan", false);
+    config.autoScanGapS = prefs.getInt("auto_scan_gap", 1800);
+    config.adaptiveInterval = prefs.getBool("adapt_ivl", false);
+    config.intervalMinS = prefs.getInt("ivl_min", 0);
+    config.intervalMaxS = prefs.getInt("ivl_max", 600);
+
+    String httpUrls = prefs.getString("http_urls", "");
+    strncpy(config.httpUrls, httpUrls.c_str(), sizeof(config.httpUrls) - 1);
+    config.httpUrls[sizeof(config.httpUrls) - 1] = '\0';
+
+    config.pathProbe = prefs.getBool("path_probe", true);
+    config.pathMaxHops = prefs.getInt("path_hops", 12);
+    config.cycleBudgetMs = prefs.getInt("cycle_budget", 10000);
+    config.telemetryEncoding = prefs.getInt("tel_enc", TELEMETRY_JSON);
+    config.telemetryDelta = prefs.getBool("tel_delta", false);
+    config.keyframeEvery = prefs.getInt("keyframe_n", 10);
+    config.batchSamples = prefs.getInt("batch_n", 1);
+    config.batchSeconds = prefs.getInt("batch_s", 300);
     return config;
 }
 
@@ -91,10 +149,37 @@ void ConfigManager::save(SystemConfig config) {
     prefs.putString("telemetry_topic", config.telemetryTopic);
     prefs.putString("cmd_topic", config.cmdTopic);
     prefs.putInt("report_interval", config.reportInterval);
+    prefs.putInt("ping_count", config.pingCount);
+    prefs.putInt("ping_interval", config.pingIntervalMs);
+    prefs.putString("probe_targets", config.probeTargets);
+    prefs.putString("dns_resolvers", config.dnsResolvers);
+    prefs.putString("dns_zone", config.dnsZone);
+    prefs.putString("dns_names", config.dnsNames);
+    prefs.putInt("dns_queries", config.dnsQueries);
+    prefs.putString("tput_url", config.tputUrl);
+    prefs.putString("tput_up_url", config.tputUploadUrl);
+    prefs.putInt("tput_duration", config.tputDurationMs);
+    prefs.putInt("tput_bytes", config.tputBytes);
+    prefs.putInt("sample_ms", config.sampleIntervalMs);
+    prefs.putBool("evt_detect", config.eventDetect);
+    prefs.putBool("auto_scan", config.autoDeepScan);
+    prefs.putInt("auto_scan_gap", config.autoScanGapS);
+    prefs.putBool("adapt_ivl", config.adaptiveInterval);
+    prefs.putInt("ivl_min", config.intervalMinS);
+    prefs.putInt("ivl_max", config.intervalMaxS);
+    prefs.putString("http_urls", config.httpUrls);
+    prefs.putBool("path_probe", config.pathProbe);
+    prefs.putInt("path_hops", config.pathMaxHops);
+    prefs.putInt("cycle_budget", config.cycleBudgetMs);
+    prefs.putInt("tel_enc", config.telemetryEncoding);
+    prefs.putBool("tel_delta", config.telemetryDelta);
+    prefs.putInt("keyframe_n", config.keyframeEvery);
+    prefs.putInt("batch_n", config.batchSamples);
+    prefs.putInt("batch_s", config.batchSeconds);
 }
 
 bool ConfigManager::updateFromJSON(const String& json) {
-    DynamicJsonDocument doc(1024);
+    DynamicJsonDocument doc(2048);
     DeserializationError error = deserializeJson(doc, json);
     if (error) return false;
     if (doc.containsKey("probe_id")) {
@@ -132,6 +217,111 @@ bool ConfigManager::updateFromJSON(const String& json) {
     if (doc.containsKey("report_interval")) {
         prefs.putInt("report_interval", doc["report_interval"].as<int>());
     }
+    if (doc.containsKey("ping_count")) {
+        prefs.putInt("ping_count", constrain(doc["ping_count"].as<int>(), 1, 32));
+    }
+    if (doc.containsKey("ping_interval_ms")) {
+        prefs.putInt("ping_interval", constrain(doc["ping_interval_ms"].as<int>(), 10, 1000));
+    }
+    if (doc.containsKey("targets")) {
+        String targets;
+        if (doc["targets"].is<JsonArray>()) {
+            JsonArray arr = doc["targets"].as<JsonArray>();
+            for (size_t i = 0; i < arr.size(); i++) {
+                if (i > 0) targets += ",";
+                targets += arr[i].as<String>();
+            }
+        } else {
+            targets = doc["targets"].as<String>();
+        }
+        setProbeTargets(targets);
+    }
+    if (doc.containsKey("dns_resolvers")) {
+        prefs.putString("dns_resolvers", doc["dns_resolvers"].as<String>());
+    }
+    if (doc.containsKey("dns_zone")) {
+        prefs.putString("dns_zone", doc["dns_zone"].as<String>());
+    }
+    if (doc.containsKey("dns_names")) {
+        prefs.putString("dns_names", doc["dns_names"].as<String>());
+    }
+    if (doc.containsKey("dns_queries")) {
+        prefs.putInt("dns_queries", constrain(doc["dns_queries"].as<int>(), 1, 16));
+    }
+    if (doc.containsKey("tput_url")) {
+        prefs.putString("tput_url", doc["tput_url"].as<String>());
+    }
+    if (doc.containsKey("tput_up_url")) {
+        prefs.putString("tput_up_url", doc["tput_up_url"].as<String>());
+    }
+    if (doc.containsKey("tput_duration_ms")) {
+        prefs.putInt("tput_duration", constrain(doc["tput_duration_ms"].as<int>(), 1000, 30000));
+    }
+    if (doc.containsKey("tput_bytes")) {
+        prefs.putInt("tput_bytes", constrain(doc["tput_bytes"].as<int>(), 16384, 16777216));
+    }
+    if (doc.containsKey("sample_interval_ms")) {
+        prefs.putInt("sample_ms", constrain(doc["sample_interval_ms"].as<int>(), 1000, 10000));
+    }
+    if (doc.containsKey("event_detect")) {
+        prefs.putBool("evt_detect", doc["event_detect"].as<bool>());
+    }
+    if (doc.containsKey("auto_deep_scan")) {
+        prefs.putBool("auto_scan", doc["auto_deep_scan"].as<bool>());
+    }
+    if (doc.containsKey("auto_scan_gap_s")) {
+        prefs.putInt("auto_scan_gap", constrain(doc["auto_scan_gap_s"].as<int>(), 300, 86400));
+    }
+    if (doc.containsKey("adaptive_interval")) {
+        prefs.putBool("adapt_ivl", doc["adaptive_interval"].as<bool>());
+    }
+    if (doc.containsKey("interval_min_s")) {
+        int minS = doc["interval_min_s"].as<int>();
+        prefs.putInt("ivl_min", minS <= 0 ? 0 : constrain(minS, 10, 3600));
+    }
+    if (doc.containsKey("interval_max_s")) {
+        prefs.putInt("ivl_max", constrain(doc["interval_max_s"].as<int>(), 30, 86400));
+    }
+    if (doc.containsKey("http_urls")) {
+        String urls;
+        if (doc["http_urls"].is<JsonArray>()) {
+            JsonArray arr = doc["http_urls"].as<JsonArray>();
+            for (size_t i = 0; i < arr.size(); i++) {
+                if (i > 0) urls += ",";
+                urls += arr[i].as<String>();
+            }
+        } else {
+            urls = doc["http_urls"].as<String>();
+        }
+        prefs.putString("http_urls", urls);
+    }
+    if (doc.containsKey("path_probe")) {
+        prefs.putBool("path_probe", doc["path_probe"].as<bool>());
+    }
+    if (doc.containsKey("path_max_hops")) {
+        prefs.putInt("path_hops", constrain(doc["path_max_hops"].as<int>(), 2, 16));
+    }
+    if (doc.containsKey("cycle_budget_ms")) {
+        prefs.putInt("cycle_budget", constrain(doc["cycle_budget_ms"].as<int>(), 1000, 60000));
+    }
+    if (doc.containsKey("telemetry_encoding")) {
+        String enc = doc["telemetry_encoding"].as<String>();
+        if (enc == "json") prefs.putInt("tel_enc", TELEMETRY_JSON);
+        else if (enc == "msgpack") prefs.putInt("tel_enc", TELEMETRY_MSGPACK);
+        else if (enc == "both") prefs.putInt("tel_enc", TELEMETRY_BOTH);
+    }
+    if (doc.containsKey("telemetry_delta")) {
+        prefs.putBool("tel_delta", doc["telemetry_delta"].as<bool>());
+    }
+    if (doc.containsKey("keyframe_every")) {
+        prefs.putInt("keyframe_n", constrain(doc["keyframe_every"].as<int>(), 1, 100));
+    }
+    if (doc.containsKey("batch_samples")) {
+        prefs.putInt("batch_n", constrain(doc["batch_samples"].as<int>(), 1, 30));
+    }
+    if (doc.containsKey("batch_seconds")) {
+        prefs.putInt("batch_s", constrain(doc["batch_seconds"].as<int>(), 10, 3600));
+    }
     if (doc.containsKey("location")) {
         setFleetLocation(doc["location"].as<String>());
     }
@@ -4,6 +4,19 @@
 #include <Preferences.h>
 #include <ArduinoJson.h>
 
+#define DEFAULT_PROBE_TARGETS "gateway,dns1,8.8.8.8"
+#define DEFAULT_DNS_RESOLVERS "dns1,dns2"
+#define DEFAULT_DNS_ZONE "google.com"
+// Empty: no download until an operator points tput_url at an on-campus
+// endpoint (plain HTTP, large enough to outlast the warm-up window)
+#define DEFAULT_TPUT_URL ""
+
+enum TelemetryEncoding {
+    TELEMETRY_JSON,
+    TELEMETRY_MSGPACK,      // numeric-key MessagePack on the parallel topic
+    TELEMETRY_BOTH          // both, while backends migrate
+};
+
 struct SystemConfig {
     char probe_id[32];
     char mqttServer[64];
@@ -11,6 +24,33 @@ struct SystemConfig {
     char telemetryTopic[128];
     char cmdTopic[128];
     int reportInterval;
+    int pingCount;
+    int pingIntervalMs;
+    char probeTargets[192];
+    char dnsResolvers[96];
+    char dnsZone[64];
+    char dnsNames[160];
+    int dnsQueries;
+    char tputUrl[160];
+    char tputUploadUrl[160];
+    int tputDurationMs;
+    int tputBytes;
+    int sampleIntervalMs;
+    bool eventDetect;
+    bool autoDeepScan;
+    int autoScanGapS;         // minimum spacing between automatic deep scans
+    bool adaptiveInterval;
+    int intervalMinS;         // 0 follows reportInterval
+    int intervalMaxS;
+    char httpUrls[256];       // comma separated, empty disables the HTTP phase
+    bool pathProbe;
+    int pathMaxHops;
+    int cycleBudgetMs;        // wall-time budget the scheduler packs each cycle into
+    int telemetryEncoding;    // TelemetryEncoding
+    bool telemetryDelta;      // keyframes plus changed-field frames
+    int keyframeEvery;        // frames per keyframe in delta mode
+    int batchSamples;         // samples per columnar publish, 1 disables batching
+    int batchSeconds;         // oldest sample a batch may hold before it goes out
 };
 
 class ConfigManager {
@@ -31,6 +71,8 @@ public:
     static void setWifi(String ssid, String password);
     static void setMqtt(String broker, int port, String user, String password);
     static void setProbeId(String newId);
+    static String getProbeTargets();
+    static void setProbeTargets(String targets);
     
     static void setFleetGroups(String groups);
     static String getFleetGroups();
@@ -4,12 +4,21 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include <LittleFS.h>
+#include <ArduinoJson.h>
 
 struct WifiCredentials {
     String ssid;
     String password;
 };
 
+// Where we were last associated, so a reconnect can skip the full scan
+struct LinkHint {
+    bool valid;
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
 class StorageManager {
 public:
     static void begin();
@@ -22,9 +31,13 @@ public:
     static int getFailureCount();
     static void incrementFailureCount();
     static void resetFailureCount();
+    static void saveLinkHint(const LinkHint& hint);
+    static LinkHint loadLinkHint();
+    static void clearLinkHint();
 
     // LittleFS Methods (for Data Buffering)
     static bool appendToBuffer(String jsonPayload);
+    static bool appendToBuffer(const JsonDocument& doc);
     static String readBuffer();
     static void clearBuffer();
     static size_t getBufferSize();
@@ -89,6 +89,29 @@ int StorageManager::getFailureCount() {
     wifiPrefs.end();
     return count;
 }
+
+void StorageManager::saveLinkHint(const LinkHint& hint) {
+    wifiPrefs.begin("wifi-creds", false);
+    wifiPrefs.putBytes("link_hint", &hint, sizeof(hint));
+    wifiPrefs.end();
+}
+
+LinkHint StorageManager::loadLinkHint() {
+    LinkHint hint;
+    memset(&hint, 0, sizeof(hint));
+    wifiPrefs.begin("wifi-creds", true);
+    if (wifiPrefs.getBytesLength("link_hint") == sizeof(hint)) {
+        wifiPrefs.getBytes("link_hint", &hint, sizeof(hint));
+    }
+    wifiPrefs.end();
+    return hint;
+}
+
+void StorageManager::clearLinkHint() {
+    wifiPrefs.begin("wifi-creds", false);
+    wifiPrefs.remove("link_hint");
+    wifiPrefs.end();
+}
 bool StorageManager::appendToBuffer(String jsonPayload) {
     File file = LittleFS.open("/buffer.json", "a");
     if (!file) return false;
@@ -102,6 +125,16 @@ bool StorageManager::appendToBuffer(String jsonPayload) {
     return false;
 }
 
+// Serializes straight into the file, one document per line
+bool StorageManager::appendToBuffer(const JsonDocument& doc) {
+    File file = LittleFS.open("/buffer.json", "a");
+    if (!file) return false;
+
+    bool ok = serializeJson(doc, file) > 0 && file.println() > 0;
+    file.close();
+    return ok;
+}
+
 size_t StorageManager::getBufferSize() {
     File file = LittleFS.open("/buffer.json", "r");
     if (!file) return 0;
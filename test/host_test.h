@@ -0,0 +1,35 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+/**
+ * Minimal check macros for the host tests; no framework to install.
+ * A failed CHECK reports and carries on, TEST_SKIP exits with 77 so
+ * ctest shows the test as skipped rather than passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        hostTestFailures++; \
+    } \
+} while (0)
+
+#define TEST_SKIP(why) do { \
+    fprintf(stderr, "skipped: %s\n", why); \
+    exit(77); \
+} while (0)
+
+#define RUN_TEST(fn) do { \
+    int before = hostTestFailures; \
+    fn(); \
+    printf("%s %s\n", hostTestFailures == before ? "PASS" : "FAIL", #fn); \
+} while (0)
+
+#define TEST_EXIT() return hostTestFailures == 0 ? 0 : 1
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef HTTP_STAND_IN_H
+#define HTTP_STAND_IN_H
+
+/**
+ * Local HTTP stand-in for the host tests. Listens on an ephemeral loopback
+ * port and serves one connection at a time from a background thread. The
+ * request head is read, any declared request body is drained and counted,
+ * then the test's handler writes whatever response it wants to the socket.
+ */
+
+#include "NetCompat.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <strings.h>
+
+struct StandInRequest {
+    char method[8];
+    char path[128];
+    long bodyBytes;     // request body actually received
+};
+
+typedef void (*StandInHandler)(int fd, const StandInRequest& req);
+
+class HttpStandIn {
+public:
+    explicit HttpStandIn(StandInHandler handler) : handler(handler), listener(-1), port(0) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+            listen(listener, 4) < 0 ||
+            getsockname(listener, (struct sockaddr*)&addr, &len) < 0) {
+            close(listener);
+            listener = -1;
+            return;
+        }
+        port = ntohs(addr.sin_port);
+        pthread_create(&thread, NULL, serve, this);
+    }
+
+    ~HttpStandIn() {
+        if (listener < 0) return;
+        shutdown(listener, SHUT_RDWR);
+        close(listener);
+        pthread_join(thread, NULL);
+    }
+
+    bool ok() const { return listener >= 0; }
+    uint16_t localPort() const { return port; }
+
+    // Writes everything or gives up quietly; the client may have hung up
+    static void sendAll(int fd, const void* data, size_t len) {
+        const char* p = (const char*)data;
+        while (len > 0) {
+            ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            p += n;
+            len -= n;
+        }
+    }
+
+    static void sendText(int fd, const char* text) { sendAll(fd, text, strlen(text)); }
+
+private:
+    static void* serve(void* arg) {
+        HttpStandIn* self = (HttpStandIn*)arg;
+        for (;;) {
+            int fd = accept(self->listener, NULL, NULL);
+            if (fd < 0) return NULL;
+            StandInRequest req;
+            if (readRequest(fd, req)) self->handler(fd, req);
+            close(fd);
+        }
+    }
+
+    static bool readRequest(int fd, StandInRequest& req) {
+        memset(&req, 0, sizeof(req));
+        char head[2048];
+        size_t used = 0;
+        char* end = NULL;
+        while (!end && used < sizeof(head) - 1) {
+            ssize_t n = recv(fd, head + used, sizeof(head) - 1 - used, 0);
+            if (n <= 0) return false;
+            used += n;
+            head[used] = '\0';
+            end = strstr(head, "\r\n\r\n");
+        }
+        if (!end) return false;
+        sscanf(head, "%7s %127s", req.method, req.path);
+
+        long declared = 0;
+        for (char* h = strstr(head, "\r\n"); h && h < end; h = strstr(h + 2, "\r\n")) {
+            if (strncasecmp(h + 2, "Content-Length:", 15) == 0) declared = atol(h + 17);
+        }
+        req.bodyBytes = (long)used - (long)(end + 4 - head);
+        char sink[4096];
+        while (req.bodyBytes < declared) {
+            ssize_t n = recv(fd, sink, sizeof(sink), 0);
+            if (n <= 0) break;
+            req.bodyBytes += n;
+        }
+        return true;
+    }
+
+    StandInHandler handler;
+    int listener;
+    uint16_t port;
+    pthread_t thread;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "host_test.h"
+#include "http_stand_in.h"
+#include "HttpTimingProbe.h"
+
+#define BODY_SIZE 50000
+#define SLOW_FIRST_BYTE_MS 300
+
+static void handle(int fd, const StandInRequest& req) {
+    static char body[BODY_SIZE];
+    memset(body, 'b', sizeof(body));
+    char head[128];
+
+    if (strcmp(req.path, "/ok") == 0 || strcmp(req.path, "/slow") == 0) {
+        if (strcmp(req.path, "/slow") == 0) netSleepMs(SLOW_FIRST_BYTE_MS);
+        snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", BODY_SIZE);
+        HttpStandIn::sendText(fd, head);
+        HttpStandIn::sendAll(fd, body, sizeof(body));
+    } else if (strcmp(req.path, "/until-close") == 0) {
+        HttpStandIn::sendText(fd, "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n");
+        HttpStandIn::sendAll(fd, body, sizeof(body));
+    } else if (strcmp(req.path, "/hangup") == 0) {
+        // Closes without a response
+    } else {
+        HttpStandIn::sendText(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+}
+
+static HttpStandIn* server;
+static HttpProbeConfig probeCfg = {2000, 1024 * 1024};
+
+static const char* urlFor(const char* scheme, const char* path) {
+    static char text[96];
+    snprintf(text, sizeof(text), "%s://127.0.0.1:%u%s", scheme, server->localPort(), path);
+    return text;
+}
+
+static void test_phases_of_a_plain_get() {
+    HttpTiming t;
+    CHECK(HttpTimingProbe::run(urlFor("http", "/ok"), probeCfg, t));
+    CHECK(t.failedPhase == HTTP_PHASE_NONE);
+    CHECK(t.status == 200);
+    CHECK(t.bytes == BODY_SIZE);
+    CHECK(t.dnsMs >= 0);
+    CHECK(t.connectMs >= 0);
+    CHECK(t.tlsMs == -1);
+    CHECK(t.ttfbMs >= 0);
+    CHECK(t.transferMs >= 0);
+    CHECK(t.totalMs >= t.ttfbMs);
+}
+
+// Server think time shows up as time to first byte, not as transfer
+static void test_slow_server_lands_in_ttfb() {
+    HttpTiming t;
+    CHECK(HttpTimingProbe::run(urlFor("http", "/slow"), probeCfg, t));
+    CHECK(t.ttfbMs >= SLOW_FIRST_BYTE_MS - 20);
+    CHECK(t.transferMs < SLOW_FIRST_BYTE_MS);
+}
+
+static void test_body_without_length_ends_on_close() {
+    HttpTiming t;
+    CHECK(HttpTimingProbe::run(urlFor("http", "/until-close"), probeCfg, t));
+    CHECK(t.bytes == BODY_SIZE);
+}
+
+static void test_byte_cap_stops_the_transfer() {
+    HttpProbeConfig capped = {2000, 10000};
+    HttpTiming t;
+    CHECK(HttpTimingProbe::run(urlFor("http", "/ok"), capped, t));
+    CHECK(t.bytes >= 10000 && t.bytes < BODY_SIZE);
+}
+
+// Any status is a completed probe; the status is reported, not judged
+static void test_error_status_still_completes() {
+    HttpTiming t;
+    CHECK(HttpTimingProbe::run(urlFor("http", "/missing"), probeCfg, t));
+    CHECK(t.status == 404);
+    CHECK(t.bytes == 0);
+}
+
+static void test_hangup_fails_in_response_phase() {
+    HttpTiming t;
+    CHECK(!HttpTimingProbe::run(urlFor("http", "/hangup"), probeCfg, t));
+    CHECK(t.failedPhase == HTTP_PHASE_RESPONSE);
+    CHECK(t.status == -1);
+    CHECK(t.connectMs >= 0);
+}
+
+static void test_refused_connect_fails_in_connect_phase() {
+    // Bind and release a port so nothing is listening on it
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(s, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(s, (struct sockaddr*)&addr, &len);
+    close(s);
+
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/", ntohs(addr.sin_port));
+    HttpTiming t;
+    CHECK(!HttpTimingProbe::run(url, probeCfg, t));
+    CHECK(t.failedPhase == HTTP_PHASE_CONNECT);
+    CHECK(t.dnsMs >= 0);
+    CHECK(t.connectMs == -1);
+}
+
+// Host builds have no TLS stack, so https stops right after connect
+static void test_https_without_tls_fails_in_tls_phase() {
+    HttpTiming t;
+    CHECK(!HttpTimingProbe::run(urlFor("https", "/ok"), probeCfg, t));
+    CHECK(t.failedPhase == HTTP_PHASE_TLS);
+    CHECK(t.connectMs >= 0);
+    CHECK(t.tlsMs == -1);
+}
+
+// .invalid never resolves (RFC 6761)
+static void test_unresolvable_host_fails_in_dns_phase() {
+    HttpTiming t;
+    CHECK(!HttpTimingProbe::run("http://no-such-host.invalid/", probeCfg, t));
+    CHECK(t.failedPhase == HTTP_PHASE_DNS);
+    CHECK(t.dnsMs == -1);
+    CHECK(t.connectMs == -1);
+}
+
+static void test_bad_url_fails_before_dns() {
+    HttpTiming t;
+    CHECK(!HttpTimingProbe::run("ftp://example.com/", probeCfg, t));
+    CHECK(t.failedPhase == HTTP_PHASE_URL);
+    CHECK(t.dnsMs == -1);
+}
+
+int main() {
+    HttpStandIn standIn(handle);
+    if (!standIn.ok()) TEST_SKIP("cannot listen on loopback");
+    server = &standIn;
+
+    RUN_TEST(test_phases_of_a_plain_get);
+    RUN_TEST(test_slow_server_lands_in_ttfb);
+    RUN_TEST(test_body_without_length_ends_on_close);
+    RUN_TEST(test_byte_cap_stops_the_transfer);
+    RUN_TEST(test_error_status_still_completes);
+    RUN_TEST(test_hangup_fails_in_response_phase);
+    RUN_TEST(test_refused_connect_fails_in_connect_phase);
+    RUN_TEST(test_https_without_tls_fails_in_tls_phase);
+    RUN_TEST(test_unresolvable_host_fails_in_dns_phase);
+    RUN_TEST(test_bad_url_fails_before_dns);
+    TEST_EXIT();
+}
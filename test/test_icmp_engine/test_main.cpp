@@ -0,0 +1,43 @@
+#include "host_test.h"
+#include "IcmpEngine.h"
+
+static uint32_t loopback() {
+    uint32_t ip = 0;
+    netResolve("127.0.0.1", ip);
+    return ip;
+}
+
+static void test_loopback_echo() {
+    IcmpConfig cfg = {5, 20, 500};
+    LatencyStats stats;
+    float rtt[ICMP_MAX_PACKETS];
+
+    CHECK(IcmpEngine::ping(loopback(), cfg, stats, rtt));
+    CHECK(stats.sent == 5);
+    CHECK(stats.received == 5);
+    CHECK(stats.lossPct == 0);
+    CHECK(stats.minMs >= 0 && stats.minMs <= stats.avgMs && stats.avgMs <= stats.maxMs);
+    CHECK(stats.maxMs < 100);
+    for (int i = 0; i < 5; i++) CHECK(rtt[i] >= 0);
+}
+
+// Two sockets to the same address: each must only count its own replies
+static void test_many_targets_keep_replies_apart() {
+    uint32_t ips[2] = {loopback(), loopback()};
+    IcmpConfig cfg = {4, 20, 500};
+    LatencyStats stats[2];
+
+    CHECK(IcmpEngine::pingMany(ips, 2, cfg, stats) == 2);
+    CHECK(stats[0].received == 4);
+    CHECK(stats[1].received == 4);
+}
+
+int main() {
+    int probe = socket(AF_INET, NET_ICMP_ECHO_SOCK_TYPE, IPPROTO_ICMP);
+    if (probe < 0) TEST_SKIP("no ICMP socket; check net.ipv4.ping_group_range");
+    close(probe);
+
+    RUN_TEST(test_loopback_echo);
+    RUN_TEST(test_many_targets_keep_replies_apart);
+    TEST_EXIT();
+}
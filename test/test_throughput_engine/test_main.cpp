@@ -0,0 +1,148 @@
+#include "host_test.h"
+#include "http_stand_in.h"
+#include "ThroughputEngine.h"
+
+#define SIZED_BODY 200000
+#define UPLOAD_BODY 300000
+
+// Chunk sizes in hex with an extension on one of them; payload is 0x1000 + 0x10 + 0x2345
+static const char* CHUNKED_FRAMES[] = { "1000", "10;name=value", "2345" };
+static const long CHUNKED_PAYLOAD = 0x1000 + 0x10 + 0x2345;
+
+static void sendChunked(int fd) {
+    static char payload[0x2345];
+    memset(payload, 'c', sizeof(payload));
+    for (size_t i = 0; i < sizeof(CHUNKED_FRAMES) / sizeof(CHUNKED_FRAMES[0]); i++) {
+        long size = strtol(CHUNKED_FRAMES[i], NULL, 16);
+        HttpStandIn::sendText(fd, CHUNKED_FRAMES[i]);
+        HttpStandIn::sendText(fd, "\r\n");
+        HttpStandIn::sendAll(fd, payload, size);
+        HttpStandIn::sendText(fd, "\r\n");
+    }
+    HttpStandIn::sendText(fd, "0\r\n\r\n");
+}
+
+static void handle(int fd, const StandInRequest& req) {
+    static char body[SIZED_BODY];
+    if (strcmp(req.path, "/sized") == 0) {
+        memset(body, 'b', sizeof(body));
+        char head[128];
+        snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n", SIZED_BODY);
+        HttpStandIn::sendText(fd, head);
+        HttpStandIn::sendAll(fd, body, sizeof(body));
+    } else if (strcmp(req.path, "/chunked") == 0) {
+        HttpStandIn::sendText(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+        sendChunked(fd);
+        // Keep the connection open: the client has to stop on the last chunk
+        netSleepMs(1500);
+    } else if (strcmp(req.path, "/sink") == 0) {
+        char head[128];
+        snprintf(head, sizeof(head), "HTTP/1.1 %s\r\nContent-Length: 0\r\n\r\n",
+                 req.bodyBytes == UPLOAD_BODY ? "200 OK" : "400 Bad Request");
+        HttpStandIn::sendText(fd, head);
+    } else {
+        HttpStandIn::sendText(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+}
+
+static HttpStandIn* server;
+
+static HttpUrl urlFor(const char* path) {
+    char text[96];
+    snprintf(text, sizeof(text), "http://127.0.0.1:%u%s", server->localPort(), path);
+    HttpUrl url;
+    parseHttpUrl(text, url);
+    return url;
+}
+
+static uint32_t loopback() {
+    uint32_t ip = 0;
+    netResolve("127.0.0.1", ip);
+    return ip;
+}
+
+static void test_download_counts_content_length_body() {
+    ThroughputConfig cfg = {5000, 10 * 1024 * 1024, 0, 2000};
+    ThroughputResult r;
+    CHECK(ThroughputEngine::download(loopback(), urlFor("/sized"), cfg, r));
+    CHECK(r.status == 200);
+    CHECK(r.bytes == SIZED_BODY);
+    CHECK(r.goodputKbps > 0);
+}
+
+static void test_download_stops_at_byte_budget() {
+    ThroughputConfig cfg = {5000, 50000, 0, 2000};
+    ThroughputResult r;
+    CHECK(ThroughputEngine::download(loopback(), urlFor("/sized"), cfg, r));
+    CHECK(r.bytes >= 50000 && r.bytes < SIZED_BODY);
+}
+
+static void test_download_decodes_chunked_body() {
+    ThroughputConfig cfg = {5000, 10 * 1024 * 1024, 0, 3000};
+    ThroughputResult r;
+    uint32_t start = netMicros();
+    CHECK(ThroughputEngine::download(loopback(), urlFor("/chunked"), cfg, r));
+    uint32_t elapsedMs = (netMicros() - start) / 1000;
+
+    CHECK(r.status == 200);
+    CHECK(r.bytes == CHUNKED_PAYLOAD);
+    CHECK(elapsedMs < 1000);
+}
+
+// Finishing inside the warm-up window measures the whole transfer instead
+static void test_short_transfer_uses_whole_window() {
+    ThroughputConfig cfg = {5000, 10 * 1024 * 1024, 4000, 2000};
+    ThroughputResult r;
+    CHECK(ThroughputEngine::download(loopback(), urlFor("/sized"), cfg, r));
+    CHECK(r.measuredBytes == SIZED_BODY);
+    CHECK(r.goodputKbps > 0);
+}
+
+static void test_download_error_status_fails() {
+    ThroughputConfig cfg = {5000, 10 * 1024 * 1024, 0, 2000};
+    ThroughputResult r;
+    CHECK(!ThroughputEngine::download(loopback(), urlFor("/missing"), cfg, r));
+    CHECK(r.status == 404);
+    CHECK(r.goodputKbps < 0);
+}
+
+static void test_upload_sends_declared_body() {
+    ThroughputConfig cfg = {5000, UPLOAD_BODY, 0, 2000};
+    ThroughputResult r;
+    CHECK(ThroughputEngine::upload(loopback(), urlFor("/sink"), cfg, r));
+    CHECK(r.bytes == UPLOAD_BODY);
+    CHECK(r.status == 200);
+    CHECK(r.goodputKbps > 0);
+}
+
+static void test_chunk_decoder_across_split_reads() {
+    const char* body = "4\r\nWiki\r\n5;x=y\r\npedia\r\nE\r\n in\r\n\r\nchunks.\r\n0\r\n\r\n";
+    HttpChunkDecoder whole;
+    CHECK(whole.feed((const uint8_t*)body, strlen(body)) == 23);
+    CHECK(whole.done());
+
+    HttpChunkDecoder split;
+    long payload = 0;
+    for (size_t i = 0; i < strlen(body); i++) payload += split.feed((const uint8_t*)body + i, 1);
+    CHECK(payload == 23);
+    CHECK(split.done());
+
+    HttpChunkDecoder bad;
+    bad.feed((const uint8_t*)"zz\r\n", 4);
+    CHECK(bad.failed());
+}
+
+int main() {
+    HttpStandIn standIn(handle);
+    if (!standIn.ok()) TEST_SKIP("cannot listen on loopback");
+    server = &standIn;
+
+    RUN_TEST(test_download_counts_content_length_body);
+    RUN_TEST(test_download_stops_at_byte_budget);
+    RUN_TEST(test_download_decodes_chunked_body);
+    RUN_TEST(test_short_transfer_uses_whole_window);
+    RUN_TEST(test_download_error_status_fails);
+    RUN_TEST(test_upload_sends_declared_body);
+    RUN_TEST(test_chunk_decoder_across_split_reads);
+    TEST_EXIT();
+}